@@ -0,0 +1,424 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <variant>
+#include <vector>
+
+#include "basic_ev_strategy.hpp"
+#include "card_constants.hpp"
+#include "card_deck_operations.hpp"
+#include "command_line.hpp"
+#include "common_constants.hpp"
+#include "game_analysis.hpp"
+#include "game_core.hpp"
+#include "game_state.hpp"
+#include "machine_description.hpp"
+#include "math.hpp"
+#include "player_strategy.hpp"
+#include "position.hpp"
+#include "property_auction.hpp"
+#include "property_constants.hpp"
+#include "random.hpp"
+#include "rent.hpp"
+
+
+// Microbenchmarks of the simulation kernels, run on game states taken from the middle of seeded games.
+// Results are written as JSON, so changes to single kernels can be compared in isolation.
+namespace monopoly::microbenchmark {
+
+	struct options_t {
+		// Only run benchmarks whose name contains this.
+		std::string filter;
+		std::optional<std::string> output_file;
+		unsigned repetitions = 5;
+		double min_seconds = 0.1;
+	};
+
+	struct result_t {
+		std::string name;
+		std::uint64_t operations = 0;
+		// Over the repetitions.
+		double median_ns_per_op = 0;
+		double min_ns_per_op = 0;
+	};
+
+	// Results are folded into this so the benchmarked work can't be optimised away.
+	inline volatile std::uint64_t sink = 0;
+
+	using game_states_t = std::vector<std::unique_ptr<game_state_t>>;
+
+	// Game states after between 10 and 60 rounds of seeded games, keeping only games still in progress.
+	[[nodiscard]]
+	game_states_t generate_game_states(std::size_t const count) {
+		game_states_t states;
+		player_strategies_t strategies;
+		for (std::uint64_t seed = 1; states.size() < count; ++seed) {
+			random_t random{seed};
+			auto const rounds = 10 + static_cast<unsigned>(random() % 51);
+			auto state = std::make_unique<game_state_t>();
+			run_new_game(*state, strategies, random, rounds);
+			if (!is_game_done(*state, std::nullopt)) {
+				states.push_back(std::move(state));
+			}
+		}
+		return states;
+	}
+
+	[[nodiscard]]
+	game_states_t clone_game_states(game_states_t const& states) {
+		game_states_t clones;
+		clones.reserve(states.size());
+		for (auto const& state : states) {
+			// game_state_t has no public copy or move constructor.
+			*clones.emplace_back(std::make_unique<game_state_t>()) = state->clone();
+		}
+		return clones;
+	}
+
+	// Times pass(), which returns the number of operations it did, until at least min_seconds has elapsed, in each
+	// repetition. setup() is called before every pass and isn't timed.
+	[[nodiscard]]
+	result_t run_benchmark(options_t const& options, std::string name, auto setup, auto pass) {
+		using float_ns = std::chrono::duration<double, std::nano>;
+		std::vector<double> ns_per_op;
+		std::uint64_t total_operations = 0;
+		for (unsigned repetition = 0; repetition < options.repetitions; ++repetition) {
+			std::chrono::steady_clock::duration elapsed{};
+			std::uint64_t operations = 0;
+			while (std::chrono::duration<double>{elapsed}.count() < options.min_seconds) {
+				setup();
+				auto const start = std::chrono::steady_clock::now();
+				operations += pass();
+				elapsed += std::chrono::steady_clock::now() - start;
+			}
+			ns_per_op.push_back(std::chrono::duration_cast<float_ns>(elapsed).count() / operations);
+			total_operations += operations;
+		}
+		std::ranges::sort(ns_per_op);
+		return {std::move(name), total_operations, ns_per_op[ns_per_op.size() / 2], ns_per_op.front()};
+	}
+
+	[[nodiscard]]
+	result_t run_benchmark(options_t const& options, std::string name, auto pass) {
+		return run_benchmark(options, std::move(name), [] {}, pass);
+	}
+
+
+	// Every (state, property) pair where the property is owned, for calculate_rent().
+	template<PropertyType P>
+	[[nodiscard]]
+	std::vector<std::pair<game_state_t const*, P>> owned_properties(game_states_t const& states, auto const& all) {
+		std::vector<std::pair<game_state_t const*, P>> result;
+		for (auto const& state : states) {
+			for (auto const property : all) {
+				if (state->property_ownership.get<P>().is_owned(property)) {
+					result.emplace_back(state.get(), property);
+				}
+			}
+		}
+		return result;
+	}
+
+	using any_property_t = std::variant<street_t, railway_t, utility_t>;
+
+	// First unowned property of each state which has one, for auction_property().
+	[[nodiscard]]
+	std::vector<std::pair<std::size_t, any_property_t>> unowned_properties(game_states_t const& states) {
+		std::vector<std::pair<std::size_t, any_property_t>> result;
+		for (std::size_t i = 0; i < states.size(); ++i) {
+			auto const& ownership = states[i]->property_ownership;
+			auto const find_unowned = [&result, &ownership, i]<PropertyType P>(auto const& all) {
+				for (auto const property : all) {
+					if (!ownership.get<P>().is_owned(property)) {
+						result.emplace_back(i, property);
+						return true;
+					}
+				}
+				return false;
+			};
+			if (!find_unowned.operator()<street_t>(streets)) {
+				if (!find_unowned.operator()<railway_t>(railways)) {
+					std::ignore = find_unowned.operator()<utility_t>(utilities);
+				}
+			}
+		}
+		return result;
+	}
+
+	// Every (state, player) pair where the player is on the board, i.e. not bankrupt or in jail.
+	[[nodiscard]]
+	std::vector<std::pair<std::size_t, unsigned>> active_players(game_states_t const& states) {
+		std::vector<std::pair<std::size_t, unsigned>> result;
+		for (std::size_t i = 0; i < states.size(); ++i) {
+			for (auto const player : players) {
+				auto const& player_state = states[i]->players[player];
+				if (!player_state.is_bankrupt() && !player_state.in_jail()) {
+					result.emplace_back(i, player);
+				}
+			}
+		}
+		return result;
+	}
+
+	// Every (state, player) pair where the player is in jail (and not bankrupt).
+	[[nodiscard]]
+	std::vector<std::pair<std::size_t, unsigned>> jailed_players(game_states_t const& states) {
+		std::vector<std::pair<std::size_t, unsigned>> result;
+		for (std::size_t i = 0; i < states.size(); ++i) {
+			for (auto const player : players) {
+				auto const& player_state = states[i]->players[player];
+				if (!player_state.is_bankrupt() && player_state.in_jail()) {
+					result.emplace_back(i, player);
+				}
+			}
+		}
+		return result;
+	}
+
+	template<card_type_t C>
+	[[nodiscard]]
+	unsigned draw_and_return_card(game_state_t& game_state) {
+		auto const card = draw_card<C>(game_state);
+		if (card == get_out_of_jail_free_card<C>) {
+			game_state.get_out_of_jail_free_ownership.set_owner(C, 0u);
+			return_get_out_of_jail_free_card<C>(game_state);
+		}
+		return static_cast<unsigned>(card);
+	}
+
+
+	[[nodiscard]]
+	std::vector<result_t> run_benchmarks(options_t const& options) {
+		constexpr std::size_t state_count = 256;
+		auto const states = generate_game_states(state_count);
+		auto scratch_states = clone_game_states(states);
+		auto const restore_scratch_states = [&states, &scratch_states] {
+			for (std::size_t i = 0; i < states.size(); ++i) {
+				*scratch_states[i] = states[i]->clone();
+			}
+		};
+		// Statistics recorded while generating states shouldn't end up in any output.
+		stat_counters = stat_counters_t{};
+
+		std::vector<result_t> results;
+		auto const add = [&options, &results](std::string_view const name, auto... functions) {
+			if (name.find(options.filter) != std::string_view::npos) {
+				results.push_back(run_benchmark(options, std::string{name}, functions...));
+				std::cerr << "  " << std::left << std::setw(44) << name << std::right << std::fixed
+					<< std::setprecision(2) << std::setw(10) << results.back().median_ns_per_op << " ns/op\n";
+			}
+		};
+
+		random_t random{12345};
+
+		add("random_t::double_dice_roll", [&random] {
+			constexpr unsigned rolls = 1024;
+			std::uint64_t checksum = 0;
+			for (unsigned i = 0; i < rolls; ++i) {
+				auto const [roll, is_double] = random.double_dice_roll();
+				checksum += roll + is_double;
+			}
+			sink = sink + checksum;
+			return std::uint64_t{rolls};
+		});
+
+		auto const owned_streets = owned_properties<street_t>(states, streets);
+		add("calculate_rent(street)", [&owned_streets] {
+			std::uint64_t checksum = 0;
+			for (auto const& [state, street] : owned_streets) {
+				checksum += calculate_rent(*state, street);
+			}
+			sink = sink + checksum;
+			return std::uint64_t{owned_streets.size()};
+		});
+
+		auto const owned_railways = owned_properties<railway_t>(states, railways);
+		add("calculate_rent(railway)", [&owned_railways] {
+			std::uint64_t checksum = 0;
+			for (auto const& [state, railway] : owned_railways) {
+				checksum += calculate_rent(*state, railway);
+			}
+			sink = sink + checksum;
+			return std::uint64_t{owned_railways.size()};
+		});
+
+		auto const owned_utilities = owned_properties<utility_t>(states, utilities);
+		add("calculate_rent(utility)", [&owned_utilities, &random] {
+			std::uint64_t checksum = 0;
+			for (auto const& [state, utility] : owned_utilities) {
+				checksum += calculate_rent(*state, random, utility);
+			}
+			sink = sink + checksum;
+			return std::uint64_t{owned_utilities.size()};
+		});
+
+		add("draw_card/return_get_out_of_jail_free_card", restore_scratch_states, [&scratch_states] {
+			std::uint64_t checksum = 0;
+			for (auto const& state : scratch_states) {
+				checksum += draw_and_return_card<card_type_t::chance>(*state);
+				checksum += draw_and_return_card<card_type_t::community_chest>(*state);
+			}
+			sink = sink + checksum;
+			return std::uint64_t{2 * scratch_states.size()};
+		});
+
+		auto const movers = active_players(states);
+		std::vector<unsigned> move_rolls(movers.size());
+		std::ranges::generate(move_rolls, [&random] { return random.double_dice_roll().roll; });
+		add("advance_position_relative", restore_scratch_states, [&scratch_states, &movers, &move_rolls] {
+			std::uint64_t checksum = 0;
+			for (std::size_t i = 0; i < movers.size(); ++i) {
+				auto const [state, player] = movers[i];
+				auto& game_state = *scratch_states[state];
+#ifndef NDEBUG
+				game_state.turn.player = player;
+#endif
+				checksum += advance_position_relative(game_state, player, move_rolls[i]);
+			}
+			sink = sink + checksum;
+			return std::uint64_t{movers.size()};
+		});
+
+		add("player_net_worths", [&states] {
+			std::uint64_t checksum = 0;
+			for (auto const& state : states) {
+				checksum += player_net_worths(*state)[0];
+			}
+			sink = sink + checksum;
+			return std::uint64_t{states.size()};
+		});
+
+		add("rank_players", [&states] {
+			std::uint64_t checksum = 0;
+			for (auto const& state : states) {
+				checksum += rank_players(*state)[0];
+			}
+			sink = sink + checksum;
+			return std::uint64_t{states.size()};
+		});
+
+		auto const auctions = unowned_properties(states);
+		player_strategies_t strategies;
+		add("auction_property", restore_scratch_states, [&scratch_states, &auctions, &strategies, &random] {
+			for (auto const& [state, property] : auctions) {
+				std::visit([&](auto const p) { auction_property(*scratch_states[state], strategies, random, p); },
+					property);
+			}
+			return std::uint64_t{auctions.size()};
+		});
+
+		auto const prisoners = jailed_players(states);
+		add("basic_ev::decide_jail_action_impl", [&states, &prisoners] {
+			double checksum = 0;
+			for (auto const& [state, player] : prisoners) {
+				auto const& game_state = *states[state];
+				auto const turn_in_jail = game_state.players[player].position + static_cast<int>(max_turns_in_jail);
+				checksum += basic_ev::decide_jail_action_impl(game_state, player, static_cast<unsigned>(turn_in_jail))
+					.second;
+			}
+			sink = sink + static_cast<std::uint64_t>(checksum);
+			return std::uint64_t{prisoners.size()};
+		});
+
+		return results;
+	}
+
+	void write_results_json(std::ostream& stream, std::vector<result_t> const& results, options_t const& options) {
+		stream.precision(6);
+		stream << "{\n\t\"machine\": ";
+		write_machine_description_json(stream, describe_machine());
+		stream << ",\n\t\"repetitions\": " << options.repetitions << ",\n\t\"benchmarks\": [";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			auto const& result = results[i];
+			stream << (i == 0 ? "\n" : ",\n") << "\t\t{\"name\": ";
+			write_json_string(stream, result.name);
+			stream << ", \"operations\": " << result.operations << ", \"median_ns_per_op\": "
+				<< result.median_ns_per_op << ", \"min_ns_per_op\": " << result.min_ns_per_op << '}';
+		}
+		stream << "\n\t]\n}\n";
+	}
+
+	void print_usage(std::ostream& stream) {
+		stream <<
+			"Usage: MonopolyMicrobenchmark [options]\n"
+			"  --filter TEXT       Only run benchmarks whose name contains TEXT.\n"
+			"  --output FILE       Write the results to FILE as JSON (default stdout).\n"
+			"  --repetitions N     Number of timed repetitions of each benchmark (default 5).\n"
+			"  --min-seconds T     Minimum time of each repetition (default 0.1).\n";
+	}
+
+	[[nodiscard]]
+	std::optional<options_t> parse_command_line(int const argc, char const* const* const argv) {
+		options_t options;
+		for (int i = 1; i < argc; ++i) {
+			std::string_view const arg{argv[i]};
+			if (i + 1 >= argc) {
+				return std::nullopt;
+			}
+			std::string_view const value{argv[++i]};
+			if (arg == "--filter") {
+				options.filter = value;
+			}
+			else if (arg == "--output") {
+				options.output_file = value;
+			}
+			else if (arg == "--repetitions") {
+				auto const repetitions = parse_number<unsigned>(value);
+				if (!repetitions.has_value() || *repetitions == 0) {
+					return std::nullopt;
+				}
+				options.repetitions = *repetitions;
+			}
+			else if (arg == "--min-seconds") {
+				auto const min_seconds = parse_number<double>(value);
+				if (!min_seconds.has_value() || *min_seconds <= 0) {
+					return std::nullopt;
+				}
+				options.min_seconds = *min_seconds;
+			}
+			else {
+				return std::nullopt;
+			}
+		}
+		return options;
+	}
+
+}
+
+
+int main(int argc, char* argv[]) {
+	using namespace monopoly::microbenchmark;
+
+	auto const options = parse_command_line(argc, argv);
+	if (!options.has_value()) {
+		print_usage(std::cerr);
+		return EXIT_FAILURE;
+	}
+
+	std::cerr << "Microbenchmarks:\n";
+	auto const results = run_benchmarks(*options);
+
+	if (options->output_file.has_value()) {
+		std::ofstream file{*options->output_file, std::ios::trunc};
+		write_results_json(file, results, *options);
+		if (!file.flush()) {
+			std::cerr << "Error: failed to write " << *options->output_file << '\n';
+			return EXIT_FAILURE;
+		}
+	}
+	else {
+		write_results_json(std::cout, results, *options);
+	}
+	return EXIT_SUCCESS;
+}
@@ -4,9 +4,11 @@
 
 #include "card_constants.hpp"
 #include "card_deck_operations.hpp"
+#include "cohort_recording.hpp"
 #include "common_types.hpp"
 #include "game_state.hpp"
 #include "property_constants.hpp"
+#include "statistics_counters.hpp"
 
 
 namespace monopoly::detail {
@@ -27,6 +29,9 @@ namespace monopoly::detail {
 			// If property isn't mortgaged then it should've been liquidated previously.
 			assert(game_state.property_development.get<P>().is_mortgaged(property));
 			game_state.property_ownership.get<P>().set_owner(property, dst_player);
+			if constexpr (record_stat_group<stat_group_t::cohorts>) {
+				record_ownership_cohort_features(game_state, dst_player, property);
+			}
 			// TODO: decide to unmortgage property or not
 			// TODO: if not unmortgage, pay interest
 			assert(false);	// Not implemented yet
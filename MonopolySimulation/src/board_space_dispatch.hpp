@@ -5,6 +5,7 @@
 #include "board_space_constants.hpp"
 #include "board_space_effects.hpp"
 #include "game_state.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "property_constants.hpp"
 #include "random.hpp"
@@ -17,7 +18,8 @@ namespace monopoly {
 		auto& player_state = game_state.players[player];
 		assert(!player_state.in_jail());
 		assert(!player_state.is_bankrupt());
-		
+		scoped_phase_timer const timer{profile_phase_t::board_space};
+
 		switch (player_state.get_board_space()) {
 		case board_space_t::go:
 			board_effects::on_go_space(game_state);
@@ -6,7 +6,9 @@
 #include "card_constants.hpp"
 #include "card_effects.hpp"
 #include "common_types.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
 
@@ -18,6 +20,10 @@ namespace monopoly {
 		[[maybe_unused]] auto const& player_state = game_state.players[player];
 		assert(!player_state.is_bankrupt());
 		assert(!player_state.in_jail());
+		scoped_phase_timer const timer{profile_phase_t::card};
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->card(game_state, player, card);
+		}
 
 		switch (card) {
 		case chance_card_t::advance_to_go:
@@ -77,6 +83,10 @@ namespace monopoly {
 		[[maybe_unused]] auto const& player_state = game_state.players[player];
 		assert(!player_state.is_bankrupt());
 		assert(!player_state.in_jail());
+		scoped_phase_timer const timer{profile_phase_t::card};
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->card(game_state, player, card);
+		}
 
 		switch (card) {
 		case community_chest_card_t::advance_to_go:
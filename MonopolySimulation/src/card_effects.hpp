@@ -22,8 +22,9 @@ namespace monopoly::card_effects {
 	inline void cash_award_from_bank(game_state_t& game_state, unsigned const player, unsigned const amount) {
 		bank_pay_player(game_state, player, amount);
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::cards>) {
 			stat_counters.cash_award_card_amount[player] += amount;
+			game_state.stats.totals.cash_award_card_amount[player] += amount;
 			stat_counters.cash_award_cards_drawn[player]++;
 		}
 
@@ -34,9 +35,10 @@ namespace monopoly::card_effects {
 			unsigned const player, unsigned const amount) {
 		auto const amount_paid = player_pay_bank(game_state, strategies, random, player, amount);
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::cards>) {
 			stat_counters.cash_fee_card_amount[player] += amount_paid;
 			stat_counters.cash_fee_cards_drawn[player]++;
+			game_state.stats.totals.cash_fee_card_amount[player] += amount_paid;
 		}
 
 		// Turn ends.
@@ -56,15 +58,18 @@ namespace monopoly::card_effects {
 			if (other_player != player && !game_state.players[other_player].is_bankrupt()) {
 				auto const amount_paid =
 					player_pay_player(game_state, strategies, random, other_player, player, amount);
-				if constexpr (record_stats) {
+				if constexpr (record_stat_group<stat_group_t::cards>) {
 					stat_counters.cash_award_card_amount[player] += amount_paid;
 					stat_counters.per_player_cash_award_card_payment_amount[other_player] += amount_paid;
 					stat_counters.per_player_cash_award_card_payment_count[other_player]++;
+					auto& totals = game_state.stats.totals;
+					totals.cash_award_card_amount[player] += amount_paid;
+					totals.per_player_cash_award_card_payment_amount[other_player] += amount_paid;
 				}
 			}
 		}
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::cards>) {
 			stat_counters.cash_award_cards_drawn[player]++;
 		}
 
@@ -77,10 +82,13 @@ namespace monopoly::card_effects {
 			if (other_player != player && !game_state.players[other_player].is_bankrupt()) {
 				auto const amount_paid =
 					player_pay_player(game_state, strategies, random, player, other_player, amount);
-				if constexpr (record_stats) {
+				if constexpr (record_stat_group<stat_group_t::cards>) {
 					stat_counters.cash_fee_card_amount[player] += amount_paid;
 					stat_counters.per_player_cash_fee_card_receive_amount[other_player] += amount_paid;
 					stat_counters.per_player_cash_fee_card_receive_count[other_player]++;
+					auto& totals = game_state.stats.totals;
+					totals.cash_fee_card_amount[player] += amount_paid;
+					totals.per_player_cash_fee_card_receive_amount[other_player] += amount_paid;
 				}
 
 				// If the player goes bankrupt, don't keep trying to pay other players.
@@ -90,7 +98,7 @@ namespace monopoly::card_effects {
 			}
 		}
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::cards>) {
 			stat_counters.cash_fee_cards_drawn[player]++;
 		}
 
@@ -6,12 +6,14 @@
 
 #include "asset_surrender.hpp"
 #include "cash_basic.hpp"
+#include "event_trace.hpp"
 #include "forced_sale.hpp"
 #include "game_state.hpp"
 #include "gameplay_constants.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
 #include "safe_numeric.hpp"
+#include "statistics_counters.hpp"
 
 
 namespace monopoly::detail {
@@ -51,6 +53,12 @@ namespace monopoly::detail {
 			assert(player_state.cash == 0);
 			assert(!player_state.is_bankrupt());
 			player_state.bankrupt_round = game_state.round;
+			if (game_state.event_trace != nullptr) [[unlikely]] {
+				game_state.event_trace->bankruptcy(game_state, player, amount - amount_payable);
+			}
+			if constexpr (record_stat_group<stat_group_t::endgame>) {
+				stat_counters.bankruptcy_cash_histogram.add(amount_payable);
+			}
 		}
 		return amount_payable;
 	}
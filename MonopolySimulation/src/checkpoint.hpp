@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+#include "common_constants.hpp"
+#include "game_range.hpp"
+#include "stat_counters_io.hpp"
+#include "statistics_counters.hpp"
+
+
+namespace monopoly {
+
+	// Progress of one simulation thread in a seeded run.
+	struct worker_checkpoint_t {
+		// All games assigned to this worker.
+		game_range_t games;
+		// Games before this have been completed and are included in counters.
+		std::uint64_t next_game = 0;
+		stat_counters_t counters;
+	};
+
+	// Everything needed to continue a seeded run and get exactly the result it would have produced uninterrupted.
+	struct checkpoint_t {
+		std::uint64_t base_seed = 0;
+		std::uint32_t max_rounds = 0;		// 0 = no limit.
+		// All games in the run.
+		game_range_t games;
+		std::vector<worker_checkpoint_t> workers;
+	};
+
+	// Initial state of a run which hasn't started yet, with the games split evenly between workers.
+	[[nodiscard]]
+	inline checkpoint_t make_checkpoint(std::uint64_t const base_seed, std::uint32_t const max_rounds,
+			game_range_t const games, unsigned const worker_count) {
+		checkpoint_t checkpoint{base_seed, max_rounds, games, std::vector<worker_checkpoint_t>(worker_count)};
+		for (unsigned i = 0; i < worker_count; ++i) {
+			auto& worker = checkpoint.workers[i];
+			worker.games = split_game_range(games, worker_count, i);
+			worker.next_game = worker.games.first;
+		}
+		return checkpoint;
+	}
+
+
+	inline constexpr std::array<char, 8> checkpoint_file_magic{'M', 'O', 'N', 'O', 'C', 'K', 'P', 'T'};
+
+	// Must be incremented whenever the layout of the file changes.
+	// Also implicitly depends on stat_counters_file_version.
+	inline constexpr std::uint32_t checkpoint_file_version = 1;
+
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, game_range_t>
+	void transfer(Archive& archive, T& range) {
+		transfer(archive, range.first);
+		transfer(archive, range.count);
+	}
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, worker_checkpoint_t>
+	void transfer(Archive& archive, T& worker) {
+		transfer(archive, worker.games);
+		transfer(archive, worker.next_game);
+		transfer(archive, worker.counters);
+	}
+
+
+	// Writes the checkpoint to a temporary file and then renames it over the previous checkpoint, so there is always
+	// a complete checkpoint on disk.
+	// Return value indicates success.
+	inline bool write_checkpoint_file(std::filesystem::path const& path, checkpoint_t const& checkpoint) {
+		auto temp_path = path;
+		temp_path += ".tmp";
+
+		{
+			std::ofstream stream{temp_path, std::ios::binary | std::ios::trunc};
+			if (!stream) {
+				return false;
+			}
+			stream.write(checkpoint_file_magic.data(), checkpoint_file_magic.size());
+			binary_writer_t writer{stream};
+			transfer(writer, checkpoint_file_version);
+			transfer(writer, stat_counters_file_version);
+			transfer(writer, player_count);
+			transfer(writer, checkpoint.base_seed);
+			transfer(writer, checkpoint.max_rounds);
+			transfer(writer, checkpoint.games);
+			auto const worker_count = static_cast<std::uint32_t>(checkpoint.workers.size());
+			transfer(writer, worker_count);
+			for (auto const& worker : checkpoint.workers) {
+				transfer(writer, worker);
+			}
+			stream.flush();
+			if (!writer.ok()) {
+				return false;
+			}
+		}
+
+		std::error_code error;
+		std::filesystem::rename(temp_path, path, error);
+		return !error;
+	}
+
+	// Return value indicates success. Fails if the file is from an incompatible version.
+	inline bool read_checkpoint_file(std::filesystem::path const& path, checkpoint_t& checkpoint) {
+		std::ifstream stream{path, std::ios::binary};
+		if (!stream) {
+			return false;
+		}
+
+		std::array<char, checkpoint_file_magic.size()> magic{};
+		stream.read(magic.data(), magic.size());
+		if (!stream || magic != checkpoint_file_magic) {
+			return false;
+		}
+
+		binary_reader_t reader{stream};
+		std::uint32_t version{};
+		std::uint32_t counters_version{};
+		std::uint32_t file_player_count{};
+		transfer(reader, version);
+		transfer(reader, counters_version);
+		transfer(reader, file_player_count);
+		if (!reader.ok() || version != checkpoint_file_version || counters_version != stat_counters_file_version
+				|| file_player_count != player_count) {
+			return false;
+		}
+
+		std::uint32_t worker_count{};
+		transfer(reader, checkpoint.base_seed);
+		transfer(reader, checkpoint.max_rounds);
+		transfer(reader, checkpoint.games);
+		transfer(reader, worker_count);
+		if (!reader.ok() || worker_count == 0 || worker_count > 65536) {
+			return false;
+		}
+
+		checkpoint.workers.assign(worker_count, {});
+		for (auto& worker : checkpoint.workers) {
+			transfer(reader, worker);
+			if (!reader.ok() || worker.next_game < worker.games.first || worker.next_game > worker.games.end()
+					|| worker.counters.games != worker.next_game - worker.games.first) {
+				return false;
+			}
+		}
+
+		return stream.peek() == std::ifstream::traits_type::eof();
+	}
+
+}
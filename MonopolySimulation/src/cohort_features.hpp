@@ -0,0 +1,64 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+
+// Per-game features of each player, for statistics conditional on what happened in the game.
+// Each player's features in a game form a bitmask, and final ranks are counted per mask (see
+// stat_counters_t::cohort_rank_counts), so any combination of features can be queried after the run.
+namespace monopoly {
+
+	enum class cohort_feature_t : unsigned {
+		// The player's first purchase from the bank was a railway.
+		first_purchase_railway,
+		// The player's first purchase from the bank was a utility.
+		first_purchase_utility,
+		// The player made the first purchase from the bank of the game.
+		first_buyer,
+		// The player completed any colour set before cohort_early_round, by purchase or from a bankrupt player.
+		early_colour_set,
+		// The player completed the orange set (at any time), by purchase or from a bankrupt player.
+		orange_set,
+		// The player owned at least 2 railways (at any time), by purchase or from a bankrupt player.
+		two_railways,
+		// The player was never sent to jail. Requires the movement statistics group.
+		never_jailed,
+		// The player was sent to jail at least cohort_often_jailed_count times. Requires the movement statistics group.
+		often_jailed
+	};
+
+	inline constexpr unsigned cohort_feature_count = 8;
+	inline constexpr unsigned cohort_mask_count = 1u << cohort_feature_count;
+
+	using cohort_mask_t = std::uint8_t;
+	static_assert(cohort_feature_count <= 8 * sizeof(cohort_mask_t));
+
+	inline constexpr unsigned cohort_early_round = 20;
+	inline constexpr unsigned cohort_often_jailed_count = 3;
+	inline constexpr unsigned orange_colour_set = 3;
+
+	// Whether the feature is only recorded with the movement statistics group, which counts jail visits.
+	[[nodiscard]]
+	constexpr bool cohort_feature_needs_movement(cohort_feature_t const feature) noexcept {
+		return feature == cohort_feature_t::never_jailed || feature == cohort_feature_t::often_jailed;
+	}
+
+	[[nodiscard]]
+	constexpr cohort_mask_t cohort_feature_bit(cohort_feature_t const feature) noexcept {
+		return static_cast<cohort_mask_t>(1u << static_cast<unsigned>(feature));
+	}
+
+	inline constexpr std::array<std::string_view, cohort_feature_count> cohort_feature_names{
+		"first purchase railway",
+		"first purchase utility",
+		"first buyer of game",
+		"colour set before round 20",
+		"orange set",
+		"2+ railways",
+		"never jailed",
+		"jailed 3+ times"
+	};
+
+}
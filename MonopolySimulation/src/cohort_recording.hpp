@@ -0,0 +1,60 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+
+#include "cohort_features.hpp"
+#include "common_types.hpp"
+#include "game_state.hpp"
+#include "statistics_counters.hpp"
+
+
+// Records the cohort features of each player as the game is played (see cohort_features.hpp).
+namespace monopoly {
+
+	// Features from the player owning the property, however they got it.
+	template<PropertyType P>
+	void record_ownership_cohort_features(game_state_t& game_state, unsigned const player, P const property) {
+		auto& mask = game_state.stats.totals.cohort_masks[player];
+		auto const& ownership = game_state.property_ownership.get<P>();
+		if constexpr (std::same_as<P, street_t>) {
+			if (ownership.owns_entire_colour_set(player, property.colour_set)) {
+				if (game_state.round < cohort_early_round) {
+					mask |= cohort_feature_bit(cohort_feature_t::early_colour_set);
+				}
+				if (property.colour_set == orange_colour_set) {
+					mask |= cohort_feature_bit(cohort_feature_t::orange_set);
+				}
+			}
+		}
+		else if constexpr (std::same_as<P, railway_t>) {
+			if (ownership.owned_count(player) >= 2) {
+				mask |= cohort_feature_bit(cohort_feature_t::two_railways);
+			}
+		}
+	}
+
+	// Features from the player buying the property from the bank.
+	template<PropertyType P>
+	void record_purchase_cohort_features(game_state_t& game_state, unsigned const player, P const property) {
+		auto& totals = game_state.stats.totals;
+		auto& mask = totals.cohort_masks[player];
+		auto const player_bit = static_cast<std::uint8_t>(1u << player);
+
+		if ((totals.players_purchased & player_bit) == 0) {
+			if (totals.players_purchased == 0) {
+				mask |= cohort_feature_bit(cohort_feature_t::first_buyer);
+			}
+			totals.players_purchased |= player_bit;
+			if constexpr (std::same_as<P, railway_t>) {
+				mask |= cohort_feature_bit(cohort_feature_t::first_purchase_railway);
+			}
+			else if constexpr (std::same_as<P, utility_t>) {
+				mask |= cohort_feature_bit(cohort_feature_t::first_purchase_utility);
+			}
+		}
+
+		record_ownership_cohort_features(game_state, player, property);
+	}
+
+}
@@ -0,0 +1,573 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "convergence.hpp"
+#include "game_output.hpp"
+#include "rare_games.hpp"
+#include "statistics_counters.hpp"
+
+
+namespace monopoly {
+
+	// Shard `index` of `count` equal slices of the games.
+	struct shard_spec_t {
+		unsigned index;
+		unsigned count;
+	};
+
+	// Game `game` of the golden configuration named `config` (see determinism_check.hpp).
+	struct golden_game_spec_t {
+		std::string config;
+		std::uint64_t game;
+	};
+
+	enum class queue_action_t {
+		init,
+		work,
+		merge
+	};
+
+	struct program_options_t {
+		bool help = false;
+
+		// Number of games to run. If convergence targets are given, this is the maximum instead.
+		std::optional<std::size_t> game_count;
+		std::optional<unsigned> threads;
+
+		// If not empty, games are run until every target is reached.
+		convergence_criteria_t convergence;
+		std::optional<double> max_seconds;
+		std::size_t games_per_chunk = 10'000;
+
+		// If set, each game is seeded from this and its index, making results reproducible.
+		std::optional<std::uint64_t> seed;
+		// If set, only this slice of the games is run and the counters are written to the output file.
+		std::optional<shard_spec_t> shard;
+		std::optional<std::filesystem::path> output_file;
+		// If set, the final statistics counters are also written to these files as text.
+		std::optional<std::filesystem::path> export_csv_file;
+		std::optional<std::filesystem::path> export_json_file;
+
+		// If set, combine the counters files in input_files instead of running games.
+		bool merge = false;
+		std::vector<std::filesystem::path> input_files;
+
+		// Shared work queue directory. What to do with it depends on queue_action.
+		std::optional<std::filesystem::path> queue_dir;
+		queue_action_t queue_action = queue_action_t::work;
+		std::uint64_t range_games = 10'000;
+		unsigned stale_seconds = 600;
+
+		// If set, seeded runs periodically save their progress to this file.
+		std::optional<std::filesystem::path> checkpoint_file;
+		unsigned checkpoint_seconds = 300;
+		// Continue the run saved in checkpoint_file instead of starting a new one.
+		bool resume = false;
+
+		// If set, seeded runs use this many worker processes instead of threads, so crashing games can be skipped.
+		std::optional<unsigned> processes;
+		std::size_t max_failures = 100;
+
+		// Number of games each thread of a seeded run advances in turn.
+		unsigned interleave = 1;
+		// If set, time seeded runs with a range of interleave values instead of printing statistics.
+		bool benchmark_interleave = false;
+		// If set, time a seeded run with 1, 2, 4, ... threads instead of printing statistics.
+		bool benchmark_scaling = false;
+		// If set, run the fixed seeded workloads of macro_benchmark.hpp instead of printing statistics.
+		bool benchmark_macro = false;
+		std::optional<std::filesystem::path> benchmark_json_file;
+		std::optional<std::filesystem::path> benchmark_baseline_file;
+		// Largest allowed proportional drop in turns/sec compared with the baseline.
+		double benchmark_tolerance = 0.05;
+		// If set, hash the golden configurations of determinism_check.hpp and write the hashes to golden_write_file
+		// and/or compare them with golden_check_file, instead of printing statistics.
+		std::optional<std::filesystem::path> golden_write_file;
+		std::optional<std::filesystem::path> golden_check_file;
+		// If set, write a per-turn trace of golden_game to golden_trace_file, or compare the game with the trace in
+		// golden_trace_check_file.
+		std::optional<std::filesystem::path> golden_trace_file;
+		std::optional<std::filesystem::path> golden_trace_check_file;
+		std::optional<golden_game_spec_t> golden_game;
+		// If set, read hardware performance counters of each simulation thread (Linux only).
+		bool hardware_counters = false;
+		// If set, the state of 1 in this many games is checked after every turn.
+		std::optional<std::uint64_t> check_invariants;
+		// If set, keep this many of the most extreme games under each criterion of rare_games.hpp, and print them.
+		std::optional<unsigned> rare_games;
+		// Criteria to keep games for. All if empty.
+		std::vector<rare_game_criterion_t> rare_game_criteria;
+		// If set, play only the game with this seed and print its summary.
+		std::optional<std::uint64_t> replay_game_seed;
+		// If set, write the events of 1 in event_trace_interval games to this file (see event_trace.hpp).
+		std::optional<std::filesystem::path> event_trace_file;
+		std::optional<std::uint64_t> event_trace_interval;
+		// If set, print the events of this file written with event_trace_file, instead of simulating.
+		std::optional<std::filesystem::path> event_trace_dump_file;
+
+		// If set, seeded runs write a record of every game to this file.
+		std::optional<std::filesystem::path> game_output_file;
+		game_output_policy_t game_output_policy = game_output_policy_t::block;
+	};
+
+
+	template<typename T>
+	[[nodiscard]]
+	std::optional<T> parse_number(std::string_view const str) {
+		T value{};
+		auto const [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+		if (error != std::errc{} || end != str.data() + str.size()) {
+			return std::nullopt;
+		}
+		return value;
+	}
+
+	inline void print_usage(std::ostream& stream) {
+		stream <<
+			"Usage: MonopolySimulation [options]\n"
+			"  --games N              Number of games to run (maximum, if using --target).\n"
+			"  --threads N            Number of simulation threads.\n"
+			"  --target METRIC:WIDTH  Run until the confidence interval half-width of METRIC is at most WIDTH.\n"
+			"                         METRIC is one of: rank, rounds. May be given multiple times.\n"
+			"  --confidence P         Confidence level of --target intervals (default 0.95).\n"
+			"  --max-seconds T        Stop --target runs after T seconds.\n"
+			"  --chunk-games N        Games per thread between --target convergence checks (default 10000).\n"
+			"  --seed S               Seed each game from S and its index, making results reproducible.\n"
+			"  --shard I/N            Run only the I'th of N slices of the games (requires --seed and --output).\n"
+			"  --output FILE          Write the statistics counters to FILE (requires --seed).\n"
+			"  --export-csv FILE      Write the statistics counters to FILE as CSV (name,value rows).\n"
+			"  --export-json FILE     Write the statistics counters to FILE as JSON.\n"
+			"  --checkpoint FILE      Periodically save progress of a --seed run to FILE.\n"
+			"  --checkpoint-seconds T Time between checkpoints (default 300).\n"
+			"  --resume               Continue the run saved in the --checkpoint file.\n"
+			"  --processes N          Run a --seed run in N worker processes, skipping games which crash.\n"
+			"  --max-failures N       Abandon a --processes run after N crashed games (default 100).\n"
+			"  --interleave K         Each thread of a --seed run advances K games one turn at a time (default 1).\n"
+			"  --benchmark-interleave Measure turns/sec of a seeded run for a range of --interleave values.\n"
+			"  --benchmark-scaling    Measure a seeded run with 1, 2, 4, ... up to --threads threads.\n"
+			"  --benchmark-macro      Measure fixed seeded workloads (1 thread unless --threads is given).\n"
+			"  --benchmark-json FILE  Write --benchmark-macro results to FILE.\n"
+			"  --benchmark-baseline FILE\n"
+			"                         Fail if --benchmark-macro throughput is below that of a --benchmark-json FILE\n"
+			"                         measured with the same --threads.\n"
+			"  --benchmark-tolerance P Allowed proportional throughput drop from the baseline (default 0.05).\n"
+			"  --game-output FILE     Write the result of every game of a --seed run to FILE.\n"
+			"  --game-output-policy P What to do if writing game results falls behind: block (default) or drop.\n"
+			"  --hardware-counters    Report instructions, cycles, branch and cache misses per turn (Linux only).\n"
+			"  --check-invariants N   Check the game state after every turn of 1 in N games, aborting on a violation.\n"
+			"  --rare-games K         Keep the seeds of the K most extreme games under each criterion.\n"
+			"  --rare-criteria LIST   Comma separated --rare-games criteria (default all recorded by this build):\n"
+			"                         sample, longest, fastest_bankruptcy, largest_rent, largest_comeback.\n"
+			"  --replay-game SEED     Play only the game with SEED (as printed by --rare-games), checking invariants.\n"
+			"  --event-trace FILE     Write the dice, moves, purchases, rents, cards, auctions and bankruptcies of\n"
+			"                         each game to FILE in a compact binary format.\n"
+			"  --event-trace-interval N\n"
+			"                         Trace only 1 in N games.\n"
+			"  --event-trace-dump FILE\n"
+			"                         Print the events of an --event-trace FILE as text.\n"
+			"\n"
+			"Usage: MonopolySimulation [--golden-write FILE] [--golden-check FILE]\n"
+			"       MonopolySimulation --golden-trace FILE --golden-game CONFIG:GAME\n"
+			"       MonopolySimulation --golden-trace-check FILE\n"
+			"  Check that results are unchanged by hashing every game of fixed seeded configurations.\n"
+			"  --golden-write FILE    Write the hashes to FILE.\n"
+			"  --golden-check FILE    Fail if the hashes differ from FILE, reporting the first differing game.\n"
+			"  --golden-trace FILE    Write the state hash after each turn of one game to FILE.\n"
+			"  --golden-game CONFIG:GAME\n"
+			"                         Game to trace, as reported by --golden-check (e.g. scalar:17).\n"
+			"  --golden-trace-check FILE\n"
+			"                         Replay the game of a --golden-trace FILE and report the first differing turn.\n"
+			"\n"
+			"Usage: MonopolySimulation --merge [--output FILE] FILE...\n"
+			"  Combine counters files written with --output and print the statistics.\n"
+			"\n"
+			"Usage: MonopolySimulation --queue-init DIR --seed S [--games N] [--range-games N]\n"
+			"       MonopolySimulation --queue-work DIR [--threads N] [--stale-seconds T]\n"
+			"       MonopolySimulation --queue-merge DIR [--output FILE]\n"
+			"  Share games between worker processes through a queue directory on a shared filesystem.\n"
+			"  --range-games N        Games per queue entry (default 10000).\n"
+			"  --stale-seconds T      Requeue claims with no heartbeat for T seconds (default 600).\n";
+	}
+
+	// Returns nullopt and prints a message if the command line is invalid.
+	[[nodiscard]]
+	inline std::optional<program_options_t> parse_command_line(int const argc, char const* const* const argv) {
+		program_options_t options;
+
+		bool report_errors = true;
+		auto const fail = [&report_errors](std::string_view const message, std::string_view const option = {}) {
+			if (!report_errors) {
+				return std::nullopt;
+			}
+			std::cerr << "Error: " << message;
+			if (!option.empty()) {
+				std::cerr << ' ' << option;
+			}
+			std::cerr << "\n\n";
+			print_usage(std::cerr);
+			return std::nullopt;
+		};
+
+		// Parses an option which takes a value. Returns false if there's no such option, or nullopt if the value is
+		// invalid.
+		auto const parse_value_option = [&options, &fail](std::string_view const arg, std::string_view const value)
+				-> std::optional<bool> {
+			if (arg == "--games") {
+				options.game_count = parse_number<std::size_t>(value);
+				if (!options.game_count.has_value()) {
+					return fail("invalid --games");
+				}
+			}
+			else if (arg == "--threads") {
+				options.threads = parse_number<unsigned>(value);
+				if (!options.threads.has_value() || *options.threads == 0) {
+					return fail("invalid --threads");
+				}
+			}
+			else if (arg == "--target") {
+				auto const separator = value.find(':');
+				if (separator == std::string_view::npos) {
+					return fail("--target must be of the form METRIC:WIDTH");
+				}
+				auto const metric = parse_convergence_metric(value.substr(0, separator));
+				auto const half_width = parse_number<double>(value.substr(separator + 1));
+				if (!metric.has_value() || !half_width.has_value() || !(*half_width > 0)) {
+					return fail("invalid --target");
+				}
+				options.convergence.targets.push_back({*metric, *half_width});
+			}
+			else if (arg == "--confidence") {
+				auto const confidence = parse_number<double>(value);
+				if (!confidence.has_value() || !(*confidence > 0 && *confidence < 1)) {
+					return fail("invalid --confidence");
+				}
+				options.convergence.confidence = *confidence;
+			}
+			else if (arg == "--max-seconds") {
+				options.max_seconds = parse_number<double>(value);
+				if (!options.max_seconds.has_value() || !(*options.max_seconds > 0)) {
+					return fail("invalid --max-seconds");
+				}
+			}
+			else if (arg == "--chunk-games") {
+				auto const chunk_games = parse_number<std::size_t>(value);
+				if (!chunk_games.has_value() || *chunk_games == 0) {
+					return fail("invalid --chunk-games");
+				}
+				options.games_per_chunk = *chunk_games;
+			}
+			else if (arg == "--seed") {
+				options.seed = parse_number<std::uint64_t>(value);
+				if (!options.seed.has_value()) {
+					return fail("invalid --seed");
+				}
+			}
+			else if (arg == "--shard") {
+				auto const separator = value.find('/');
+				if (separator == std::string_view::npos) {
+					return fail("--shard must be of the form I/N");
+				}
+				auto const index = parse_number<unsigned>(value.substr(0, separator));
+				auto const count = parse_number<unsigned>(value.substr(separator + 1));
+				if (!index.has_value() || !count.has_value() || *index >= *count) {
+					return fail("invalid --shard");
+				}
+				options.shard = shard_spec_t{*index, *count};
+			}
+			else if (arg == "--output") {
+				options.output_file = value;
+			}
+			else if (arg == "--export-csv") {
+				options.export_csv_file = value;
+			}
+			else if (arg == "--export-json") {
+				options.export_json_file = value;
+			}
+			else if (arg == "--queue-init" || arg == "--queue-work" || arg == "--queue-merge") {
+				options.queue_dir = value;
+				options.queue_action = arg == "--queue-init" ? queue_action_t::init
+					: arg == "--queue-work" ? queue_action_t::work : queue_action_t::merge;
+			}
+			else if (arg == "--checkpoint") {
+				options.checkpoint_file = value;
+			}
+			else if (arg == "--checkpoint-seconds") {
+				auto const checkpoint_seconds = parse_number<unsigned>(value);
+				if (!checkpoint_seconds.has_value()) {
+					return fail("invalid --checkpoint-seconds");
+				}
+				options.checkpoint_seconds = *checkpoint_seconds;
+			}
+			else if (arg == "--processes") {
+				options.processes = parse_number<unsigned>(value);
+				if (!options.processes.has_value() || *options.processes == 0) {
+					return fail("invalid --processes");
+				}
+			}
+			else if (arg == "--max-failures") {
+				auto const max_failures = parse_number<std::size_t>(value);
+				if (!max_failures.has_value()) {
+					return fail("invalid --max-failures");
+				}
+				options.max_failures = *max_failures;
+			}
+			else if (arg == "--interleave") {
+				auto const interleave = parse_number<unsigned>(value);
+				if (!interleave.has_value() || *interleave == 0) {
+					return fail("invalid --interleave");
+				}
+				options.interleave = *interleave;
+			}
+			else if (arg == "--game-output") {
+				options.game_output_file = value;
+			}
+			else if (arg == "--game-output-policy") {
+				if (value == "block") {
+					options.game_output_policy = game_output_policy_t::block;
+				}
+				else if (value == "drop") {
+					options.game_output_policy = game_output_policy_t::drop;
+				}
+				else {
+					return fail("invalid --game-output-policy");
+				}
+			}
+			else if (arg == "--benchmark-json") {
+				options.benchmark_json_file = value;
+			}
+			else if (arg == "--benchmark-baseline") {
+				options.benchmark_baseline_file = value;
+			}
+			else if (arg == "--benchmark-tolerance") {
+				auto const tolerance = parse_number<double>(value);
+				if (!tolerance.has_value() || !(*tolerance >= 0 && *tolerance < 1)) {
+					return fail("invalid --benchmark-tolerance");
+				}
+				options.benchmark_tolerance = *tolerance;
+			}
+			else if (arg == "--check-invariants") {
+				auto const interval = parse_number<std::uint64_t>(value);
+				if (!interval.has_value() || *interval == 0) {
+					return fail("invalid --check-invariants");
+				}
+				options.check_invariants = *interval;
+			}
+			else if (arg == "--rare-games") {
+				auto const capacity = parse_number<unsigned>(value);
+				if (!capacity.has_value() || *capacity == 0) {
+					return fail("invalid --rare-games");
+				}
+				options.rare_games = *capacity;
+			}
+			else if (arg == "--rare-criteria") {
+				for (auto const name : std::views::split(value, ',')) {
+					auto const criterion = std::ranges::find(rare_game_criterion_names,
+						std::string_view{name.begin(), name.end()});
+					if (criterion == rare_game_criterion_names.end()) {
+						return fail("invalid --rare-criteria");
+					}
+					auto const index = static_cast<unsigned>(criterion - rare_game_criterion_names.begin());
+					if (!rare_game_criterion_available[index]) {
+						return fail("statistics disabled in this build for --rare-criteria", *criterion);
+					}
+					options.rare_game_criteria.push_back(static_cast<rare_game_criterion_t>(index));
+				}
+			}
+			else if (arg == "--replay-game") {
+				auto const seed = parse_number<std::uint64_t>(value);
+				if (!seed.has_value()) {
+					return fail("invalid --replay-game");
+				}
+				options.replay_game_seed = *seed;
+			}
+			else if (arg == "--event-trace") {
+				options.event_trace_file = value;
+			}
+			else if (arg == "--event-trace-interval") {
+				auto const interval = parse_number<std::uint64_t>(value);
+				if (!interval.has_value() || *interval == 0) {
+					return fail("invalid --event-trace-interval");
+				}
+				options.event_trace_interval = *interval;
+			}
+			else if (arg == "--event-trace-dump") {
+				options.event_trace_dump_file = value;
+			}
+			else if (arg == "--golden-write") {
+				options.golden_write_file = value;
+			}
+			else if (arg == "--golden-check") {
+				options.golden_check_file = value;
+			}
+			else if (arg == "--golden-trace") {
+				options.golden_trace_file = value;
+			}
+			else if (arg == "--golden-trace-check") {
+				options.golden_trace_check_file = value;
+			}
+			else if (arg == "--golden-game") {
+				auto const colon = value.rfind(':');
+				auto const game = colon != std::string_view::npos
+					? parse_number<std::uint64_t>(value.substr(colon + 1)) : std::nullopt;
+				if (!game.has_value() || colon == 0) {
+					return fail("invalid --golden-game");
+				}
+				options.golden_game = golden_game_spec_t{std::string{value.substr(0, colon)}, *game};
+			}
+			else if (arg == "--range-games") {
+				auto const range_games = parse_number<std::uint64_t>(value);
+				if (!range_games.has_value() || *range_games == 0) {
+					return fail("invalid --range-games");
+				}
+				options.range_games = *range_games;
+			}
+			else if (arg == "--stale-seconds") {
+				auto const stale_seconds = parse_number<unsigned>(value);
+				if (!stale_seconds.has_value() || *stale_seconds == 0) {
+					return fail("invalid --stale-seconds");
+				}
+				options.stale_seconds = *stale_seconds;
+			}
+			else {
+				return false;
+			}
+			return true;
+		};
+
+		for (int i = 1; i < argc; ++i) {
+			std::string_view const arg{argv[i]};
+			if (arg == "--help") {
+				options.help = true;
+				continue;
+			}
+			if (arg == "--merge") {
+				options.merge = true;
+				continue;
+			}
+			if (arg == "--resume") {
+				options.resume = true;
+				continue;
+			}
+			if (arg == "--benchmark-interleave") {
+				options.benchmark_interleave = true;
+				continue;
+			}
+			if (arg == "--benchmark-scaling") {
+				options.benchmark_scaling = true;
+				continue;
+			}
+			if (arg == "--benchmark-macro") {
+				options.benchmark_macro = true;
+				continue;
+			}
+			if (arg == "--hardware-counters") {
+				options.hardware_counters = true;
+				continue;
+			}
+			if (!arg.starts_with("--")) {
+				options.input_files.emplace_back(arg);
+				continue;
+			}
+
+			if (i + 1 >= argc) {
+				// Only options which take a value can be missing one, so try parsing a placeholder value.
+				report_errors = false;
+				auto const known = parse_value_option(arg, {});
+				report_errors = true;
+				return fail(known == false ? "unknown option" : "missing value for option", arg);
+			}
+			auto const parsed = parse_value_option(arg, argv[++i]);
+			if (!parsed.has_value()) {
+				return std::nullopt;
+			}
+			if (!*parsed) {
+				return fail("unknown option", arg);
+			}
+		}
+
+		if (!options.input_files.empty() && !options.merge) {
+			return fail("input files are only used with --merge");
+		}
+		if (options.resume && (options.shard.has_value() || options.game_count.has_value()
+				|| options.threads.has_value() || options.seed.has_value())) {
+			return fail("--shard, --games, --threads and --seed can't be used with --resume (the checkpoint already "
+				"records the games and threads)");
+		}
+		if (options.shard.has_value() && (!options.seed.has_value() || !options.output_file.has_value())) {
+			return fail("--shard requires --seed and --output");
+		}
+		if (options.queue_dir.has_value() && options.queue_action == queue_action_t::init
+				&& !options.seed.has_value()) {
+			return fail("--queue-init requires --seed");
+		}
+		if (options.resume && !options.checkpoint_file.has_value()) {
+			return fail("--resume requires --checkpoint");
+		}
+		if (options.checkpoint_file.has_value() && !options.seed.has_value() && !options.resume) {
+			return fail("--checkpoint requires --seed");
+		}
+		if (options.output_file.has_value() && !options.seed.has_value() && !options.merge
+				&& !options.queue_dir.has_value() && !options.resume) {
+			return fail("--output requires --seed");
+		}
+		if (options.processes.has_value() && (!options.seed.has_value() || options.checkpoint_file.has_value()
+				|| options.queue_dir.has_value() || options.merge)) {
+			return fail("--processes requires --seed, and can't be used with --checkpoint or a work queue");
+		}
+		if (options.interleave > 1 && (!options.seed.has_value() || options.checkpoint_file.has_value()
+				|| options.processes.has_value() || options.queue_dir.has_value() || options.merge)) {
+			return fail("--interleave requires --seed, and can't be used with --checkpoint, --processes or a work "
+				"queue");
+		}
+		if (options.game_output_file.has_value() && (!options.seed.has_value() || options.checkpoint_file.has_value()
+				|| options.processes.has_value() || options.queue_dir.has_value() || options.merge)) {
+			return fail("--game-output requires --seed, and can't be used with --checkpoint, --processes or a work "
+				"queue");
+		}
+		if (!options.rare_game_criteria.empty() && !options.rare_games.has_value()) {
+			return fail("--rare-criteria requires --rare-games");
+		}
+		// The reservoirs aren't saved in checkpoints, so a resumed run would only cover the games after resuming.
+		if (options.rare_games.has_value() && (options.processes.has_value() || options.queue_dir.has_value()
+				|| options.merge || options.checkpoint_file.has_value())) {
+			return fail("--rare-games can't be used with --processes, a work queue, --merge or --checkpoint");
+		}
+		if (options.event_trace_interval.has_value() && !options.event_trace_file.has_value()) {
+			return fail("--event-trace-interval requires --event-trace");
+		}
+		// A resumed run would overwrite the trace of the games before it was interrupted.
+		if (options.event_trace_file.has_value() && (options.processes.has_value() || options.queue_dir.has_value()
+				|| options.merge || options.event_trace_dump_file.has_value() || options.resume)) {
+			return fail("--event-trace can't be used with --processes, a work queue, --merge, --event-trace-dump or "
+				"--resume");
+		}
+		if (options.golden_trace_file.has_value() != options.golden_game.has_value()) {
+			return fail("--golden-trace and --golden-game must be given together");
+		}
+		auto const is_rank_target = [](convergence_target_t const& target) {
+			return target.metric == convergence_metric_t::avg_player_rank;
+		};
+		if (!record_stat_group<stat_group_t::endgame>
+				&& std::ranges::any_of(options.convergence.targets, is_rank_target)) {
+			return fail("rank statistics are disabled in this build");
+		}
+		if (options.seed.has_value() && !options.convergence.targets.empty()) {
+			return fail("--seed can't be used with --target");
+		}
+
+		return options;
+	}
+
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <cmath>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "common_constants.hpp"
+#include "statistics_counters.hpp"
+
+
+namespace monopoly {
+
+	// Per-game quantities whose mean can be used as a stopping criterion.
+	enum class convergence_metric_t {
+		// Average rank of every player. All players must converge.
+		avg_player_rank,
+		// Average number of rounds per game.
+		avg_rounds_per_game
+	};
+
+	[[nodiscard]]
+	constexpr std::string_view convergence_metric_name(convergence_metric_t const metric) noexcept {
+		switch (metric) {
+		case convergence_metric_t::avg_player_rank:
+			return "rank";
+		case convergence_metric_t::avg_rounds_per_game:
+			return "rounds";
+		}
+		return "";
+	}
+
+	[[nodiscard]]
+	constexpr std::optional<convergence_metric_t> parse_convergence_metric(std::string_view const name) noexcept {
+		for (auto const metric : {convergence_metric_t::avg_player_rank, convergence_metric_t::avg_rounds_per_game}) {
+			if (name == convergence_metric_name(metric)) {
+				return metric;
+			}
+		}
+		return std::nullopt;
+	}
+
+
+	struct convergence_target_t {
+		convergence_metric_t metric;
+		// Required half-width of the confidence interval of the metric's mean.
+		double half_width;
+	};
+
+	struct convergence_criteria_t {
+		std::vector<convergence_target_t> targets;
+		// Two-sided confidence level of the intervals.
+		double confidence = 0.95;
+	};
+
+
+	// Standard normal quantile z such that P(-z < Z < z) = confidence.
+	[[nodiscard]]
+	inline double normal_two_sided_quantile(double const confidence) {
+		// Bisection on erf is plenty fast for something computed once per run.
+		double low = 0;
+		double high = 10;
+		for (unsigned i = 0; i < 100; ++i) {
+			auto const mid = (low + high) / 2;
+			if (std::erf(mid / std::sqrt(2.0)) < confidence) {
+				low = mid;
+			}
+			else {
+				high = mid;
+			}
+		}
+		return (low + high) / 2;
+	}
+
+	// Half-width of the normal-approximation confidence interval of the mean.
+	// Infinite if there are too few samples to estimate the variance.
+	[[nodiscard]]
+	inline double confidence_half_width(moment_accumulator const& moments, double const z) {
+		return z * moments.standard_error();
+	}
+
+	// Largest confidence interval half-width over everything the metric covers.
+	[[nodiscard]]
+	inline double confidence_half_width(stat_counters_t const& counters, convergence_metric_t const metric,
+			double const z) {
+		switch (metric) {
+		case convergence_metric_t::avg_player_rank: {
+			double result = 0;
+			for (auto const player : players) {
+				result = std::fmax(result, confidence_half_width(counters.player_rank_moments[player], z));
+			}
+			return result;
+		}
+		case convergence_metric_t::avg_rounds_per_game:
+			return confidence_half_width(counters.game_length_moments, z);
+		}
+		return std::numeric_limits<double>::infinity();
+	}
+
+	[[nodiscard]]
+	inline bool is_converged(stat_counters_t const& counters, convergence_criteria_t const& criteria) {
+		auto const z = normal_two_sided_quantile(criteria.confidence);
+		for (auto const& target : criteria.targets) {
+			if (!(confidence_half_width(counters, target.metric, z) <= target.half_width)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+}
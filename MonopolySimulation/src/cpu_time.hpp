@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+
+namespace monopoly {
+
+	// Total CPU time (user + kernel) used by all threads of this process so far.
+	// std::clock() isn't suitable since it measures wall time on Windows.
+	[[nodiscard]]
+	inline double process_cpu_seconds() noexcept {
+#ifdef _WIN32
+		FILETIME creation_time;
+		FILETIME exit_time;
+		FILETIME kernel_time;
+		FILETIME user_time;
+		if (!GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time)) {
+			return 0;
+		}
+		// Units of 100ns.
+		auto const ticks = [](FILETIME const time) {
+			return (static_cast<std::uint64_t>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+		};
+		return (ticks(kernel_time) + ticks(user_time)) * 100e-9;
+#else
+		timespec time{};
+		if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &time) != 0) {
+			return 0;
+		}
+		return time.tv_sec + time.tv_nsec * 1e-9;
+#endif
+	}
+
+}
@@ -0,0 +1,497 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "common_types.hpp"
+#include "game_observer.hpp"
+#include "game_range.hpp"
+#include "game_state.hpp"
+#include "player_strategy.hpp"
+#include "property_constants.hpp"
+#include "random.hpp"
+#include "simulation.hpp"
+#include "stat_counters_io.hpp"
+#include "statistics_counters.hpp"
+
+
+// Golden-seed determinism check, for changes which must not alter results (e.g. performance refactors).
+// Fixed seeded configurations are run, and the final state of every game and the merged statistics counters are
+// hashed. The hashes are saved to a file and compared with those of another build. If a game differs, a per-turn
+// trace of it from both builds finds the first turn where they diverge.
+// Configurations which need a different build (all players always rolling in jail) are named after the build
+// variant. Counters are only compared if both builds record them, so e.g. a build with statistics disabled can
+// still be checked against the game hashes of a standard build.
+namespace monopoly {
+
+	// 64-bit FNV-1a. Every value is hashed as a 64-bit integer, so hashes don't depend on the host or member types.
+	class state_hasher_t {
+	public:
+		template<typename T> requires std::integral<T> || std::is_enum_v<T>
+		void add(T const value) noexcept {
+			if constexpr (std::is_enum_v<T>) {
+				add_bits(static_cast<std::uint64_t>(static_cast<std::underlying_type_t<T>>(value)));
+			}
+			else {
+				add_bits(static_cast<std::uint64_t>(value));
+			}
+		}
+
+		void add(double const value) noexcept {
+			add_bits(std::bit_cast<std::uint64_t>(value));
+		}
+
+		template<typename T>
+		void add(std::optional<T> const& value) noexcept {
+			add(value.has_value());
+			if (value.has_value()) {
+				add(*value);
+			}
+		}
+
+		// Archive interface of stat_counters_io.hpp, so counters can be hashed with transfer().
+		template<std::unsigned_integral T>
+		void value(T const& value) noexcept {
+			add(value);
+		}
+
+		void value(double const& value) noexcept {
+			add(value);
+		}
+
+		[[nodiscard]]
+		std::uint64_t hash() const noexcept {
+			return _hash;
+		}
+
+	private:
+		std::uint64_t _hash = 0xcbf29ce484222325u;
+
+		void add_bits(std::uint64_t const bits) noexcept {
+			for (unsigned i = 0; i < 8; ++i) {
+				_hash ^= (bits >> (8 * i)) & 0xFFu;
+				_hash *= 0x100000001b3u;
+			}
+		}
+	};
+
+	// Hash of the game, excluding the per-game statistics (which are covered by the counters hashes) and debug-only
+	// members.
+	[[nodiscard]]
+	inline std::uint64_t hash_game_state(game_state_t const& game_state) noexcept {
+		state_hasher_t hasher;
+		for (auto const& player : game_state.players) {
+			hasher.add(player.position);
+			hasher.add(player.bankrupt_round);
+			hasher.add(player.consecutive_doubles);
+			hasher.add(player.cash);
+			hasher.add(player.houses_owned);
+			hasher.add(player.hotels_owned);
+		}
+		for (auto const& street : streets) {
+			hasher.add(game_state.property_ownership.street.get_owner(street));
+			hasher.add(game_state.property_development.street.development_level(street));
+			hasher.add(game_state.street_development.development_level(street));
+		}
+		for (auto const railway : railways) {
+			hasher.add(game_state.property_ownership.railway.get_owner(railway));
+			hasher.add(game_state.property_development.railway.is_mortgaged(railway));
+			hasher.add(game_state.railway_development.is_mortgaged(railway));
+		}
+		for (auto const utility : utilities) {
+			hasher.add(game_state.property_ownership.utility.get_owner(utility));
+			hasher.add(game_state.property_development.utility.is_mortgaged(utility));
+			hasher.add(game_state.utility_development.is_mortgaged(utility));
+		}
+		auto const add_deck = [&](auto const& deck, card_type_t const card_type) {
+			for (auto const card : deck.cards) {
+				hasher.add(card);
+			}
+			hasher.add(deck.top_index);
+			auto const owner = game_state.get_out_of_jail_free_ownership.get_owner(card_type);
+			hasher.add(owner);
+			// Only reset on return in debug builds, so stale otherwise.
+			if (owner.has_value()) {
+				hasher.add(deck.get_out_of_jail_free_index);
+			}
+		};
+		add_deck(game_state.chance_deck, card_type_t::chance);
+		add_deck(game_state.community_chest_deck, card_type_t::community_chest);
+		hasher.add(game_state.round);
+		hasher.add(game_state.turn.movement_roll);
+		hasher.add(game_state.turn.railway_rent_multiplier);
+		hasher.add(game_state.turn.utility_rent_dice_multiplier_override);
+		return hasher.hash();
+	}
+
+	// Counters which measure the run rather than its results, so aren't hashed.
+	inline constexpr std::array<std::string_view, 3> unhashed_stat_counters{
+		"simulation_time_seconds",
+		"hardware_counter_values",
+		"hardware_counter_turns"
+	};
+
+	struct named_hash_t {
+		std::string name;
+		std::uint64_t hash = 0;
+	};
+
+	// Hash of each counter recorded by this build, in registry order.
+	[[nodiscard]]
+	inline std::vector<named_hash_t> hash_stat_counters(stat_counters_t const& counters) {
+		std::vector<named_hash_t> hashes;
+		for_each_stat_counter([&](auto const& info) {
+			if (!is_stat_group_recorded(info.group)
+					|| std::ranges::find(unhashed_stat_counters, info.name) != unhashed_stat_counters.end()) {
+				return;
+			}
+			state_hasher_t hasher;
+			transfer(hasher, counters.*info.member);
+			hashes.push_back({std::string{info.name}, hasher.hash()});
+		});
+		return hashes;
+	}
+
+
+	struct golden_config_t {
+		std::string_view name;
+		std::uint64_t base_seed;
+		std::uint64_t game_count;
+		std::uint32_t max_rounds;
+		// Select the engine which plays the games. Counters are merged from threads in a fixed order, so are still
+		// deterministic.
+		unsigned threads;
+		unsigned interleave;
+	};
+
+	inline constexpr std::array<golden_config_t, 4> golden_configs{{
+		{"scalar", 1, 5000, 100, 1, 1},
+		{"threaded", 2, 5000, 100, 3, 1},
+		{"interleaved", 3, 5000, 100, 2, 8},
+		{"long_games", 4, 500, 1000, 1, 1}
+	}};
+
+	// Describes the build configuration which affects how games are played.
+	[[nodiscard]]
+	inline std::string_view golden_variant() noexcept {
+		return always_roll_jail ? "always_roll_jail" : "standard";
+	}
+
+	// The configuration named e.g. "scalar", or nullptr.
+	[[nodiscard]]
+	inline golden_config_t const* find_golden_config(std::string_view const name) noexcept {
+		auto const config = std::ranges::find(golden_configs, name, &golden_config_t::name);
+		return config != golden_configs.end() ? &*config : nullptr;
+	}
+
+	[[nodiscard]]
+	inline std::string golden_result_name(golden_config_t const& config) {
+		return std::string{golden_variant()} + '/' + std::string{config.name};
+	}
+
+	struct golden_result_t {
+		// Variant and configuration, e.g. "standard/scalar".
+		std::string name;
+		std::vector<named_hash_t> counters;
+		// Final state hash of each game, by index.
+		std::vector<std::uint64_t> games;
+	};
+
+	// State hash after each turn of a game, to find the first turn where two builds diverge.
+	struct golden_trace_t {
+		struct turn_t {
+			unsigned round = 0;
+			std::uint64_t hash = 0;
+		};
+
+		// Configuration, without the variant, and game index.
+		std::string config;
+		std::uint64_t game = 0;
+		// Variant of the build which played the game.
+		std::string variant;
+		// The last entry is the state at the end of the game.
+		std::vector<turn_t> turns;
+	};
+
+	namespace determinism_check_detail {
+
+		// Hashes the final state of every game in a range, and optionally traces one of them turn by turn, from
+		// whichever engine plays them.
+		class golden_observer_t final : public seeded_game_observer_t, private turn_hook_t {
+		public:
+			golden_observer_t(game_range_t const games, golden_trace_t* const trace)
+				: _first_game{games.first}, _game_hashes(games.count), _trace{trace} {
+				seeded_game_observer = this;
+			}
+
+			golden_observer_t(golden_observer_t const&) = delete;
+			golden_observer_t& operator=(golden_observer_t const&) = delete;
+
+			~golden_observer_t() {
+				seeded_game_observer = nullptr;
+			}
+
+			[[nodiscard]]
+			turn_hook_t* turn_hook(std::uint64_t const game) override {
+				return is_traced(game) ? this : nullptr;
+			}
+
+			// Each game has its own slot, so threads don't need to synchronise.
+			void after_game(std::uint64_t const game, game_state_t const& game_state) override {
+				auto const hash = hash_game_state(game_state);
+				_game_hashes[game - _first_game] = hash;
+				if (is_traced(game)) {
+					_trace->turns.push_back({game_state.round, hash});
+				}
+			}
+
+			[[nodiscard]]
+			std::vector<std::uint64_t>& game_hashes() noexcept {
+				return _game_hashes;
+			}
+
+		private:
+			std::uint64_t _first_game;
+			std::vector<std::uint64_t> _game_hashes;
+			golden_trace_t* _trace;
+
+			[[nodiscard]]
+			bool is_traced(std::uint64_t const game) const noexcept {
+				return _trace != nullptr && game == _trace->game;
+			}
+
+			void after_turn(game_state_t const& game_state, unsigned) override {
+				_trace->turns.push_back({game_state.round, hash_game_state(game_state)});
+			}
+		};
+
+		[[nodiscard]]
+		inline player_strategies_t golden_strategies() {
+			return player_strategies_t{};
+		}
+
+	}
+
+	// Games are hashed from the configuration's own engine (threaded, interleaved...), so each configuration checks
+	// what that engine plays.
+	[[nodiscard]]
+	inline golden_result_t run_golden_config(golden_config_t const& config) {
+		game_range_t const games{0, config.game_count};
+		determinism_check_detail::golden_observer_t observer{games, nullptr};
+		run_seeded_simulations_multithreaded(determinism_check_detail::golden_strategies, config.base_seed, games,
+			config.max_rounds, config.threads, config.interleave);
+		return {
+			.name = golden_result_name(config),
+			.counters = hash_stat_counters(stat_counters),
+			.games = std::move(observer.game_hashes())
+		};
+	}
+
+	namespace determinism_check_detail {
+
+		inline constexpr std::string_view hashes_header = "monopoly-golden-hashes 1";
+		inline constexpr std::string_view trace_header = "monopoly-golden-trace 1";
+
+		inline void write_hash(std::ostream& stream, std::uint64_t const hash) {
+			stream << std::hex << std::setw(16) << std::setfill('0') << hash << std::dec << std::setfill(' ');
+		}
+
+		[[nodiscard]]
+		inline std::optional<std::uint64_t> parse_hash(std::string_view const str) {
+			std::uint64_t hash = 0;
+			auto const [end, error] = std::from_chars(str.data(), str.data() + str.size(), hash, 16);
+			if (error != std::errc{} || end != str.data() + str.size()) {
+				return std::nullopt;
+			}
+			return hash;
+		}
+
+	}
+
+	// One hash per line, e.g. "standard/scalar game 17 0123456789abcdef".
+	inline void write_golden_results(std::ostream& stream, std::vector<golden_result_t> const& results) {
+		stream << determinism_check_detail::hashes_header << '\n';
+		for (auto const& result : results) {
+			for (auto const& counter : result.counters) {
+				stream << result.name << " counter " << counter.name << ' ';
+				determinism_check_detail::write_hash(stream, counter.hash);
+				stream << '\n';
+			}
+			for (std::size_t g = 0; g < result.games.size(); ++g) {
+				stream << result.name << " game " << g << ' ';
+				determinism_check_detail::write_hash(stream, result.games[g]);
+				stream << '\n';
+			}
+		}
+	}
+
+	// Reads a file written by write_golden_results(). nullopt if it can't be read.
+	[[nodiscard]]
+	inline std::optional<std::vector<golden_result_t>> read_golden_results(std::filesystem::path const& path) {
+		std::ifstream stream{path};
+		std::string line;
+		if (!std::getline(stream, line) || line != determinism_check_detail::hashes_header) {
+			return std::nullopt;
+		}
+		std::vector<golden_result_t> results;
+		while (std::getline(stream, line)) {
+			std::istringstream fields{line};
+			std::string name, kind, key, hash_str;
+			if (!(fields >> name >> kind >> key >> hash_str)) {
+				return std::nullopt;
+			}
+			auto const hash = determinism_check_detail::parse_hash(hash_str);
+			if (!hash.has_value()) {
+				return std::nullopt;
+			}
+			if (results.empty() || results.back().name != name) {
+				results.push_back({.name = name, .counters = {}, .games = {}});
+			}
+			auto& result = results.back();
+			if (kind == "counter") {
+				result.counters.push_back({key, *hash});
+			}
+			// Games are written in order.
+			else if (kind == "game" && key == std::to_string(result.games.size())) {
+				result.games.push_back(*hash);
+			}
+			else {
+				return std::nullopt;
+			}
+		}
+		return results;
+	}
+
+	struct golden_comparison_t {
+		std::string name;
+		std::uint64_t differing_games = 0;
+		std::optional<std::uint64_t> first_differing_game;
+		// Counters recorded by both builds whose hashes differ.
+		std::vector<std::string> differing_counters;
+		bool game_count_differs = false;
+
+		[[nodiscard]]
+		bool matches() const noexcept {
+			return differing_games == 0 && differing_counters.empty() && !game_count_differs;
+		}
+	};
+
+	[[nodiscard]]
+	inline golden_comparison_t compare_golden_results(golden_result_t const& expected,
+			golden_result_t const& actual) {
+		golden_comparison_t comparison{
+			.name = actual.name,
+			.differing_games = 0,
+			.first_differing_game = std::nullopt,
+			.differing_counters = {},
+			.game_count_differs = false
+		};
+		comparison.game_count_differs = expected.games.size() != actual.games.size();
+		for (std::size_t g = 0; g < std::min(expected.games.size(), actual.games.size()); ++g) {
+			if (expected.games[g] != actual.games[g]) {
+				comparison.differing_games++;
+				if (!comparison.first_differing_game.has_value()) {
+					comparison.first_differing_game = g;
+				}
+			}
+		}
+		for (auto const& counter : actual.counters) {
+			auto const expected_counter = std::ranges::find(expected.counters, counter.name, &named_hash_t::name);
+			if (expected_counter != expected.counters.end() && expected_counter->hash != counter.hash) {
+				comparison.differing_counters.push_back(counter.name);
+			}
+		}
+		return comparison;
+	}
+
+
+	// Plays one game of the configuration with the configuration's engine, hashing the state after every turn.
+	[[nodiscard]]
+	inline golden_trace_t trace_golden_game(golden_config_t const& config, std::uint64_t const game) {
+		golden_trace_t trace{
+			.config = std::string{config.name},
+			.game = game,
+			.variant = std::string{golden_variant()},
+			.turns = {}
+		};
+		// Games are independent, so only the traced game is played.
+		game_range_t const games{game, 1};
+		determinism_check_detail::golden_observer_t const observer{games, &trace};
+		run_seeded_simulations_multithreaded(determinism_check_detail::golden_strategies, config.base_seed, games,
+			config.max_rounds, 1, config.interleave);
+		return trace;
+	}
+
+	inline void write_golden_trace(std::ostream& stream, golden_trace_t const& trace) {
+		stream << determinism_check_detail::trace_header << '\n';
+		stream << trace.variant << ' ' << trace.config << ' ' << trace.game << '\n';
+		for (auto const& turn : trace.turns) {
+			stream << turn.round << ' ';
+			determinism_check_detail::write_hash(stream, turn.hash);
+			stream << '\n';
+		}
+	}
+
+	// Reads a file written by write_golden_trace(). nullopt if it can't be read.
+	[[nodiscard]]
+	inline std::optional<golden_trace_t> read_golden_trace(std::filesystem::path const& path) {
+		std::ifstream stream{path};
+		std::string line;
+		if (!std::getline(stream, line) || line != determinism_check_detail::trace_header) {
+			return std::nullopt;
+		}
+		golden_trace_t trace;
+		if (!std::getline(stream, line)) {
+			return std::nullopt;
+		}
+		std::istringstream game_fields{line};
+		if (!(game_fields >> trace.variant >> trace.config >> trace.game)) {
+			return std::nullopt;
+		}
+		while (std::getline(stream, line)) {
+			std::istringstream fields{line};
+			golden_trace_t::turn_t turn;
+			std::string hash_str;
+			if (!(fields >> turn.round >> hash_str)) {
+				return std::nullopt;
+			}
+			auto const hash = determinism_check_detail::parse_hash(hash_str);
+			if (!hash.has_value()) {
+				return std::nullopt;
+			}
+			turn.hash = *hash;
+			trace.turns.push_back(turn);
+		}
+		return trace;
+	}
+
+	// Index of the first turn where the traces differ, or nullopt if they're the same.
+	// If one trace is a prefix of the other, it's the index just past the shorter one.
+	[[nodiscard]]
+	inline std::optional<std::size_t> first_differing_turn(golden_trace_t const& expected,
+			golden_trace_t const& actual) {
+		auto const [expected_turn, actual_turn] = std::ranges::mismatch(expected.turns, actual.turns,
+			[](auto const& lhs, auto const& rhs) { return lhs.round == rhs.round && lhs.hash == rhs.hash; });
+		if (expected_turn == expected.turns.end() && actual_turn == actual.turns.end()) {
+			return std::nullopt;
+		}
+		return static_cast<std::size_t>(actual_turn - actual.turns.begin());
+	}
+
+}
@@ -0,0 +1,525 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "board_space_names.hpp"
+#include "common_constants.hpp"
+#include "common_types.hpp"
+#include "game_state.hpp"
+#include "gameplay_constants.hpp"
+#include "property_values.hpp"
+#include "stat_counters_io.hpp"
+
+
+// Turn by turn record of sampled games (dice, moves, purchases, rents, cards, auctions, bankruptcies) for offline
+// analysis, written as a compact binary stream.
+// Each event is a tag byte (event type in the low 4 bits, player in the high 4 bits) followed by varint fields, with
+// values delta encoded where that makes them small: moves relative to the player's previous position, prices relative
+// to the list price, and rounds relative to the previous round event, which is only written when the round changes.
+// A game's events are buffered while it's played, then appended to a per-thread block which is written to the file
+// in one go once it's large, so threads rarely contend for the file.
+//
+// File layout:
+//   "MONOEVNT", version (u32 little endian), player count (u32 little endian), then games until the end of the file.
+// Each game starts with a game_start event carrying its seed (see --replay-game) and ends with a game_end event.
+// Games are grouped by thread and are not in game order.
+namespace monopoly {
+
+	inline constexpr std::array<char, 8> event_trace_file_magic{'M', 'O', 'N', 'O', 'E', 'V', 'N', 'T'};
+
+	// Must be incremented whenever the encoding of events or the file changes.
+	inline constexpr std::uint32_t event_trace_file_version = 1;
+
+	enum class trace_event_t : std::uint8_t {
+		// Seed.
+		game_start,
+		game_end,
+		// Round delta.
+		round,
+		// Roll << 1 | is double.
+		dice,
+		// Position delta (zigzag).
+		move,
+		// Property, cost delta from the list price (zigzag).
+		buy,
+		// Property, owner, rent.
+		rent,
+		// Card.
+		chance_card,
+		community_chest_card,
+		// Property, best bid. The player is the winner, if any.
+		auction,
+		// Amount the player couldn't pay.
+		bankruptcy
+	};
+
+	// Player field of events which don't have one.
+	inline constexpr unsigned trace_no_player = 0xF;
+	static_assert(player_count < trace_no_player);
+
+	// Streets, then railways, then utilities.
+	template<PropertyType P>
+	[[nodiscard]]
+	constexpr unsigned trace_property_code(P const property) noexcept {
+		if constexpr (std::same_as<P, street_t>) {
+			return property.generic_index;
+		}
+		else if constexpr (std::same_as<P, railway_t>) {
+			return street_count + static_cast<unsigned>(property);
+		}
+		else {
+			return street_count + railway_count + static_cast<unsigned>(property);
+		}
+	}
+
+
+	// Events of the game in progress.
+	class event_trace_t {
+	public:
+		void begin_game(std::uint64_t const seed) {
+			_size = 0;
+			_round = 0;
+			_positions.fill(0);
+			start_event(trace_event_t::game_start, trace_no_player);
+			varint(seed);
+		}
+
+		// Appends the game's events to the calling thread's block, writing the block out if it's full.
+		void end_game(game_state_t const& game_state);
+
+		void dice(game_state_t const& game_state, unsigned const player, unsigned const roll, bool const is_double) {
+			start_event(game_state, trace_event_t::dice, player);
+			varint(roll << 1 | is_double);
+		}
+
+		void move(game_state_t const& game_state, unsigned const player, int const position) {
+			start_event(game_state, trace_event_t::move, player);
+			zigzag(position - std::exchange(_positions[player], position));
+		}
+
+		template<PropertyType P>
+		void buy(game_state_t const& game_state, unsigned const player, P const property, unsigned const cost) {
+			start_event(game_state, trace_event_t::buy, player);
+			varint(trace_property_code(property));
+			zigzag(static_cast<std::int64_t>(cost) - property_buy_cost(property));
+		}
+
+		template<PropertyType P>
+		void rent(game_state_t const& game_state, unsigned const player, P const property, unsigned const owner,
+				unsigned const rent) {
+			start_event(game_state, trace_event_t::rent, player);
+			varint(trace_property_code(property));
+			varint(owner);
+			varint(rent);
+		}
+
+		template<typename C> requires std::same_as<C, chance_card_t> || std::same_as<C, community_chest_card_t>
+		void card(game_state_t const& game_state, unsigned const player, C const card) {
+			start_event(game_state, std::same_as<C, chance_card_t> ? trace_event_t::chance_card
+				: trace_event_t::community_chest_card, player);
+			varint(static_cast<unsigned>(card));
+		}
+
+		template<PropertyType P>
+		void auction(game_state_t const& game_state, P const property, std::optional<unsigned> const winner,
+				unsigned const best_bid) {
+			start_event(game_state, trace_event_t::auction, winner.value_or(trace_no_player));
+			varint(trace_property_code(property));
+			varint(best_bid);
+		}
+
+		void bankruptcy(game_state_t const& game_state, unsigned const player, unsigned const shortfall) {
+			start_event(game_state, trace_event_t::bankruptcy, player);
+			varint(shortfall);
+		}
+
+	private:
+		// Enough for any event plus a round event before it.
+		static constexpr std::size_t max_event_size = 32;
+
+		// Capacity is the size of the vector, since only _size bytes are used.
+		std::vector<std::uint8_t> _bytes;
+		std::size_t _size = 0;
+		unsigned _round = 0;
+		std::array<int, player_count> _positions{};
+
+		void start_event(trace_event_t const event, unsigned const player) {
+			if (_bytes.size() - _size < max_event_size) {
+				_bytes.resize(std::max<std::size_t>(2 * _bytes.size(), 4096));
+			}
+			_bytes[_size++] = static_cast<std::uint8_t>(static_cast<unsigned>(event) | player << 4);
+		}
+
+		void start_event(game_state_t const& game_state, trace_event_t const event, unsigned const player) {
+			if (game_state.round != _round) {
+				assert(game_state.round > _round);
+				start_event(trace_event_t::round, trace_no_player);
+				varint(game_state.round - std::exchange(_round, game_state.round));
+			}
+			start_event(event, player);
+		}
+
+		void varint(std::uint64_t value) noexcept {
+			while (value >= 0x80) {
+				_bytes[_size++] = static_cast<std::uint8_t>(value | 0x80);
+				value >>= 7;
+			}
+			_bytes[_size++] = static_cast<std::uint8_t>(value);
+		}
+
+		void zigzag(std::int64_t const value) noexcept {
+			varint(static_cast<std::uint64_t>(value) << 1 ^ static_cast<std::uint64_t>(value >> 63));
+		}
+	};
+
+
+	class event_trace_writer_t {
+	public:
+		// Opens the file. Failure to open the file is reported by finish().
+		explicit event_trace_writer_t(std::filesystem::path const& path) :
+			_stream{path, std::ios::binary | std::ios::trunc}
+		{
+			_stream.write(event_trace_file_magic.data(), event_trace_file_magic.size());
+			binary_writer_t writer{_stream};
+			transfer(writer, event_trace_file_version);
+			transfer(writer, player_count);
+		}
+
+		event_trace_writer_t(event_trace_writer_t const&) = delete;
+		event_trace_writer_t& operator=(event_trace_writer_t const&) = delete;
+
+		// Appends whole games. Thread safe.
+		void write(std::span<std::uint8_t const> const bytes, std::uint64_t const games) {
+			std::lock_guard const lock{_mutex};
+			_stream.write(reinterpret_cast<char const*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+			_games += games;
+			_bytes += bytes.size();
+		}
+
+		// Writes the calling thread's remaining games and closes the file. Other threads which traced games must have
+		// exited. Return value indicates success.
+		bool finish();
+
+		[[nodiscard]]
+		std::uint64_t game_count() const noexcept {
+			return _games;
+		}
+
+		// Excluding the file header.
+		[[nodiscard]]
+		std::uint64_t byte_count() const noexcept {
+			return _bytes;
+		}
+
+	private:
+		std::mutex _mutex;
+		std::ofstream _stream;
+		std::uint64_t _games = 0;
+		std::uint64_t _bytes = 0;
+	};
+
+	// 1 in this many games is traced, 0 = none. Set, along with event_trace_writer, before starting simulation threads.
+	inline std::uint64_t event_trace_interval = 0;
+	inline event_trace_writer_t* event_trace_writer = nullptr;
+
+	namespace event_trace_detail {
+
+		// Games are written in blocks of at least this size.
+		inline constexpr std::size_t block_size = 1 << 20;
+
+		struct thread_block_t {
+			std::vector<std::uint8_t> bytes;
+			std::uint64_t games = 0;
+
+			~thread_block_t() {
+				flush();
+			}
+
+			void flush() {
+				if (games > 0) {
+					assert(event_trace_writer != nullptr);
+					event_trace_writer->write(bytes, games);
+					bytes.clear();
+					games = 0;
+				}
+			}
+		};
+
+		thread_local inline thread_block_t thread_block;
+		thread_local inline event_trace_t thread_trace;
+
+	}
+
+	inline void event_trace_t::end_game(game_state_t const& game_state) {
+		start_event(game_state, trace_event_t::game_end, trace_no_player);
+		auto& block = event_trace_detail::thread_block;
+		block.bytes.insert(block.bytes.end(), _bytes.begin(), _bytes.begin() + static_cast<std::ptrdiff_t>(_size));
+		++block.games;
+		if (block.bytes.size() >= event_trace_detail::block_size) {
+			block.flush();
+		}
+	}
+
+	inline bool event_trace_writer_t::finish() {
+		event_trace_detail::thread_block.flush();
+		_stream.close();
+		return !_stream.fail();
+	}
+
+	// Whether the game with this index is traced. Seeded games are sampled by their index in the run, unseeded games by
+	// unseeded_sample_index().
+	[[nodiscard]]
+	inline bool is_event_trace_sampled(std::uint64_t const game) noexcept {
+		return event_trace_interval != 0 && game % event_trace_interval == 0;
+	}
+
+	// The calling thread's trace, begun for the game, or nullptr if the game isn't traced.
+	// For games played one at a time; interleaved games each need their own event_trace_t.
+	[[nodiscard]]
+	inline event_trace_t* begin_sampled_event_trace(std::uint64_t const game, std::uint64_t const seed) {
+		if (!is_event_trace_sampled(game)) {
+			return nullptr;
+		}
+		event_trace_detail::thread_trace.begin_game(seed);
+		return &event_trace_detail::thread_trace;
+	}
+
+
+	namespace event_trace_detail {
+
+		class event_reader_t {
+		public:
+			explicit event_reader_t(std::istream& stream) noexcept :
+				_stream{&stream}
+			{}
+
+			[[nodiscard]]
+			std::optional<std::uint64_t> varint() {
+				std::uint64_t value = 0;
+				for (unsigned shift = 0; shift < 64; shift += 7) {
+					auto const byte = _stream->get();
+					if (byte == std::istream::traits_type::eof()) {
+						return std::nullopt;
+					}
+					value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+					if ((byte & 0x80) == 0) {
+						return value;
+					}
+				}
+				return std::nullopt;
+			}
+
+			[[nodiscard]]
+			std::optional<std::int64_t> zigzag() {
+				auto const value = varint();
+				if (!value.has_value()) {
+					return std::nullopt;
+				}
+				return static_cast<std::int64_t>(*value >> 1) ^ -static_cast<std::int64_t>(*value & 1);
+			}
+
+		private:
+			std::istream* _stream;
+		};
+
+		[[nodiscard]]
+		inline std::optional<std::string_view> trace_property_name(std::uint64_t const code) {
+			if (code < street_count) {
+				return street_names[code];
+			}
+			if (code < street_count + railway_count) {
+				return railway_names[code - street_count];
+			}
+			if (code < street_count + railway_count + utility_count) {
+				return utility_names[code - street_count - railway_count];
+			}
+			return std::nullopt;
+		}
+
+		[[nodiscard]]
+		inline unsigned trace_property_buy_cost(std::uint64_t const code) {
+			if (code < street_count) {
+				return property_buy_cost(street_t{static_cast<unsigned>(code)});
+			}
+			if (code < street_count + railway_count) {
+				return property_buy_cost(static_cast<railway_t>(code - street_count));
+			}
+			return property_buy_cost(static_cast<utility_t>(code - street_count - railway_count));
+		}
+
+	}
+
+	// Writes the events of a file written by event_trace_writer_t as text, one per line.
+	// Return value indicates if the whole file was valid.
+	inline bool dump_event_trace(std::istream& stream, std::ostream& out) {
+		std::array<char, event_trace_file_magic.size()> magic{};
+		stream.read(magic.data(), magic.size());
+		std::uint32_t version = 0;
+		std::uint32_t file_player_count = 0;
+		binary_reader_t header_reader{stream};
+		transfer(header_reader, version);
+		transfer(header_reader, file_player_count);
+		if (!stream || magic != event_trace_file_magic || version != event_trace_file_version
+				|| file_player_count != player_count) {
+			return false;
+		}
+
+		event_trace_detail::event_reader_t reader{stream};
+		auto const property_name = [&reader]() -> std::optional<std::pair<std::uint64_t, std::string_view>> {
+			auto const code = reader.varint();
+			if (!code.has_value()) {
+				return std::nullopt;
+			}
+			auto const name = event_trace_detail::trace_property_name(*code);
+			if (!name.has_value()) {
+				return std::nullopt;
+			}
+			return std::pair{*code, *name};
+		};
+
+		bool in_game = false;
+		std::uint64_t round = 0;
+		std::array<long long, player_count> positions{};
+		while (true) {
+			auto const tag = stream.get();
+			if (tag == std::istream::traits_type::eof()) {
+				// Only valid between games.
+				return !in_game;
+			}
+			auto const event = static_cast<trace_event_t>(tag & 0xF);
+			auto const player = static_cast<unsigned>(tag) >> 4;
+			auto const has_player = player < player_count;
+			if ((event == trace_event_t::game_start) == in_game) {
+				return false;
+			}
+			if (!has_player && player != trace_no_player) {
+				return false;
+			}
+
+			switch (event) {
+			case trace_event_t::game_start: {
+				auto const seed = reader.varint();
+				if (!seed.has_value()) {
+					return false;
+				}
+				out << "game (seed " << *seed << ")\nround 0\n";
+				in_game = true;
+				round = 0;
+				positions.fill(0);
+				break;
+			}
+			case trace_event_t::game_end:
+				out << "end after " << round << " rounds\n";
+				in_game = false;
+				break;
+			case trace_event_t::round: {
+				auto const delta = reader.varint();
+				if (!delta.has_value()) {
+					return false;
+				}
+				round += *delta;
+				out << "round " << round << '\n';
+				break;
+			}
+			case trace_event_t::dice: {
+				auto const roll = reader.varint();
+				if (!roll.has_value() || !has_player) {
+					return false;
+				}
+				out << "  player " << player << " rolls " << (*roll >> 1) << ((*roll & 1) != 0 ? " (double)\n" : "\n");
+				break;
+			}
+			case trace_event_t::move: {
+				auto const delta = reader.zigzag();
+				// Any valid position is less than a board's length from the previous one.
+				constexpr auto max_delta = static_cast<std::int64_t>(board_space_count + max_turns_in_jail);
+				if (!delta.has_value() || !has_player || *delta <= -max_delta || *delta >= max_delta) {
+					return false;
+				}
+				positions[player] += *delta;
+				// Negative positions are turns in jail.
+				if (positions[player] < -static_cast<long long>(max_turns_in_jail)
+						|| positions[player] >= static_cast<long long>(board_space_count)) {
+					return false;
+				}
+				out << "  player " << player << " moves to " << board_position_name(positions[player]) << '\n';
+				break;
+			}
+			case trace_event_t::buy: {
+				auto const property = property_name();
+				auto const delta = reader.zigzag();
+				if (!property.has_value() || !delta.has_value() || !has_player) {
+					return false;
+				}
+				out << "  player " << player << " buys " << property->second << " for "
+					<< event_trace_detail::trace_property_buy_cost(property->first) + *delta << '\n';
+				break;
+			}
+			case trace_event_t::rent: {
+				auto const property = property_name();
+				auto const owner = reader.varint();
+				auto const rent = reader.varint();
+				if (!property.has_value() || !owner.has_value() || !rent.has_value() || !has_player) {
+					return false;
+				}
+				out << "  player " << player << " pays " << *rent << " rent to player " << *owner << " for "
+					<< property->second << '\n';
+				break;
+			}
+			case trace_event_t::chance_card:
+			case trace_event_t::community_chest_card: {
+				auto const card = reader.varint();
+				if (!card.has_value() || !has_player) {
+					return false;
+				}
+				auto const deck = event == trace_event_t::chance_card ? "Chance" : "Community Chest";
+				out << "  player " << player << " draws " << deck << " card " << *card << '\n';
+				break;
+			}
+			case trace_event_t::auction: {
+				auto const property = property_name();
+				auto const best_bid = reader.varint();
+				if (!property.has_value() || !best_bid.has_value()) {
+					return false;
+				}
+				out << "  auction of " << property->second << ": ";
+				if (has_player) {
+					out << "player " << player << " wins at " << *best_bid << '\n';
+				}
+				else if (*best_bid != 0) {
+					out << "not sold, tied bids of " << *best_bid << '\n';
+				}
+				else {
+					out << "not sold, no bids\n";
+				}
+				break;
+			}
+			case trace_event_t::bankruptcy: {
+				auto const shortfall = reader.varint();
+				if (!shortfall.has_value() || !has_player) {
+					return false;
+				}
+				out << "  player " << player << " is bankrupt, " << *shortfall << " short\n";
+				break;
+			}
+			default:
+				return false;
+			}
+		}
+	}
+
+}
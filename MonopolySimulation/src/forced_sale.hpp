@@ -4,6 +4,7 @@
 
 #include "game_state.hpp"
 #include "generic_sell_to_bank.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
 
@@ -16,6 +17,7 @@ namespace monopoly {
 		auto const& player_cash = game_state.players[player].cash;
 		auto const cash_required = player_cash + min_amount;
 		assert(min_amount > 0);
+		scoped_phase_timer const timer{profile_phase_t::forced_sale};
 		while (true) {
 			auto const sell_choices = strategies.visit(player,
 				[&game_state, &random, min_amount](PlayerStrategy auto& strategy) {
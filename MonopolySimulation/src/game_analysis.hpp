@@ -3,10 +3,14 @@
 #include <algorithm>
 #include <array>
 #include <cassert>
+#include <cstdint>
+#include <limits>
 #include <numeric>
 
+#include "cohort_features.hpp"
 #include "common_constants.hpp"
 #include "game_state.hpp"
+#include "phase_profiler.hpp"
 #include "property_constants.hpp"
 #include "property_query.hpp"
 #include "property_values.hpp"
@@ -16,10 +20,13 @@
 
 namespace monopoly {
 
-	[[nodiscard]]
-	inline std::array<unsigned long long, player_count> player_net_worths(game_state_t const& game_state) {
-		std::array<unsigned long long, player_count> net_worths{};
+	struct player_assets_t {
+		std::array<unsigned long long, player_count> net_worths;
+		std::array<unsigned, player_count> property_counts;
+	};
 
+	[[nodiscard]]
+	inline player_assets_t player_assets(game_state_t const& game_state) {
 		// Assume net worth consists of:
 		//   - Cash
 		//   - Unmortgaged streets, listed purchase price
@@ -31,53 +38,84 @@ namespace monopoly {
 		//   - Houses, purchase price
 		//   - Hotels, purchase price + 4x house purchase price
 
+		// Unowned properties are added to an extra slot rather than branching on ownership, since this is computed
+		// every round for the round series statistics.
+		constexpr unsigned unowned = player_count;
+		std::array<unsigned long long, player_count + 1> net_worths{};
+		std::array<unsigned, player_count + 1> property_counts{};
+		// Sums are far too small to overflow, so safe_uint_add() isn't needed.
+		static_assert(street_count * (std::ranges::max(street_values) + 5 * std::ranges::max(building_values))
+			+ railway_count * railway_value + utility_count * utility_value
+			< std::numeric_limits<unsigned long long>::max() - std::numeric_limits<std::uint32_t>::max());
+
 		// Cash on hand.
 		for (auto const player : players) {
-			safe_uint_add(net_worths[player], game_state.players[player].cash);
+			net_worths[player] += game_state.players[player].cash;
 		}
 
 		// Streets and buildings.
 		for (auto const& street : streets) {
-			if (auto const owner = game_state.property_ownership.street.get_owner(street); owner.has_value()) {
-				if (game_state.street_development.is_mortgaged(street)) {
-					safe_uint_add(net_worths[*owner], property_mortgage_value(street));
-				}
-				else {
-					auto const listed_value = street_values[street.generic_index];
-					auto const building_level = game_state.street_development.building_level(street);
-					// Note that a hotel is equivalent to 5 houses.
-					auto const value = listed_value + building_values[street.colour_set] * building_level;
-					safe_uint_add(net_worths[*owner], value);
-				}
-			}
+			auto const owner = game_state.property_ownership.street.get_owner(street).value_or(unowned);
+			auto const listed_value = street_values[street.generic_index];
+			auto const building_level = game_state.street_development.building_level(street);
+			// Note that a hotel is equivalent to 5 houses.
+			auto const value = game_state.street_development.is_mortgaged(street) ? property_mortgage_value(street)
+				: listed_value + building_values[street.colour_set] * building_level;
+			net_worths[owner] += value;
+			++property_counts[owner];
 		}
 
 		// Railways.
 		for (auto const railway : railways) {
-			if (auto const owner = game_state.property_ownership.railway.get_owner(railway); owner.has_value()) {
-				auto const value =
-					game_state.railway_development.is_mortgaged(railway) ? railway_mortgage_value : railway_value;
-				safe_uint_add(net_worths[*owner], value);
-			}
+			auto const owner = game_state.property_ownership.railway.get_owner(railway).value_or(unowned);
+			net_worths[owner] +=
+				game_state.railway_development.is_mortgaged(railway) ? railway_mortgage_value : railway_value;
+			++property_counts[owner];
 		}
 
 		// Utilities.
 		for (auto const utility : utilities) {
-			if (auto const owner = game_state.property_ownership.utility.get_owner(utility); owner.has_value()) {
-				auto const value =
-					game_state.utility_development.is_mortgaged(utility) ? utility_mortgage_value : utility_value;
-				safe_uint_add(net_worths[*owner], value);
-			}
+			auto const owner = game_state.property_ownership.utility.get_owner(utility).value_or(unowned);
+			net_worths[owner] +=
+				game_state.utility_development.is_mortgaged(utility) ? utility_mortgage_value : utility_value;
+			++property_counts[owner];
 		}
 
-		// A player should have 0 net worth if they're bankrupt, otherwise something has gone wrong.
+		player_assets_t result{};
 		for (auto const player : players) {
-			if (game_state.players[player].is_bankrupt()) {
-				assert(net_worths[player] == 0);
-			}
+			// A player should have 0 net worth if they're bankrupt, otherwise something has gone wrong.
+			assert(!game_state.players[player].is_bankrupt() || net_worths[player] == 0);
+			result.net_worths[player] = net_worths[player];
+			result.property_counts[player] = property_counts[player];
 		}
+		return result;
+	}
 
-		return net_worths;
+	[[nodiscard]]
+	inline std::array<unsigned long long, player_count> player_net_worths(game_state_t const& game_state) {
+		return player_assets(game_state).net_worths;
+	}
+
+
+	// Adds the current state of the game to the round series statistics, at index game_state.round.
+	// Also tracks how far each player has been behind the leader, for rare_games.hpp.
+	inline void record_round_series(game_state_t& game_state) {
+		if constexpr (record_stat_group<stat_group_t::round_series>) {
+			scoped_phase_timer const timer{profile_phase_t::stats};
+			auto const index = round_series_index(game_state.round);
+			auto const assets = player_assets(game_state);
+			auto const leader_net_worth = std::ranges::max(assets.net_worths);
+			stat_counters.round_series_games[index]++;
+			for (auto const player : players) {
+				auto const& player_state = game_state.players[player];
+				stat_counters.round_series_cash[player][index] += player_state.cash;
+				stat_counters.round_series_net_worth[player][index] += assets.net_worths[player];
+				stat_counters.round_series_property_count[player][index] += assets.property_counts[player];
+				stat_counters.round_series_bankrupt_count[player][index] += player_state.is_bankrupt();
+				auto& max_deficit = game_state.stats.totals.max_net_worth_deficit[player];
+				max_deficit = std::max(max_deficit, leader_net_worth - assets.net_worths[player]);
+			}
+		}
 	}
 
 
@@ -129,17 +167,50 @@ namespace monopoly {
 		return player_ranks;
 	}
 
-	inline void game_end_analysis(game_state_t const& game_state) {
-		if constexpr (record_stats) {
-			auto const net_worths = player_net_worths(game_state);
+	// Adds the game's final ranks to the cohort statistics, under each player's features.
+	inline void record_game_cohorts(game_state_t const& game_state, std::array<unsigned, player_count> const& ranks) {
+		if constexpr (record_stat_group<stat_group_t::cohorts>) {
+			auto const& totals = game_state.stats.totals;
+			for (auto const player : players) {
+				auto mask = totals.cohort_masks[player];
+				// Jail counts are only recorded with the movement group (see cohort_feature_needs_movement()).
+				if constexpr (record_stat_group<stat_group_t::movement>) {
+					auto const jail_count = totals.sent_to_jail_count[player];
+					if (jail_count == 0) {
+						mask |= cohort_feature_bit(cohort_feature_t::never_jailed);
+					}
+					if (jail_count >= cohort_often_jailed_count) {
+						mask |= cohort_feature_bit(cohort_feature_t::often_jailed);
+					}
+				}
+				stat_counters.cohort_rank_counts[player][mask][ranks[player]]++;
+			}
+		}
+	}
 
+	inline void game_end_analysis(game_state_t const& game_state) {
+		constexpr bool endgame = record_stat_group<stat_group_t::endgame>;
+		constexpr bool cohorts = record_stat_group<stat_group_t::cohorts>;
+		if constexpr (endgame || cohorts) {
 			auto const player_rankings = rank_players(game_state);
-			for (auto const player : players) {
-				stat_counters.player_rank[player] += player_rankings[player];
+
+			if constexpr (endgame) {
+				auto const net_worths = player_net_worths(game_state);
+
+				for (auto const player : players) {
+					stat_counters.player_rank[player] += player_rankings[player];
+					stat_counters.player_rank_moments[player].add(player_rankings[player]);
+				}
+
+				for (auto const player : players) {
+					stat_counters.final_net_worth[player] += net_worths[player];
+					stat_counters.final_net_worth_moments[player].add(static_cast<double>(net_worths[player]));
+					stat_counters.final_net_worth_histogram[player].add(net_worths[player]);
+				}
 			}
 
-			for (auto const player : players) {
-				stat_counters.final_net_worth[player] += net_worths[player];
+			if constexpr (cohorts) {
+				record_game_cohorts(game_state, player_rankings);
 			}
 		}
 	}
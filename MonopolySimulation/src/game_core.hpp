@@ -1,6 +1,8 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
+#include <cstdint>
 #include <limits>
 #include <numeric>
 #include <optional>
@@ -8,7 +10,12 @@
 
 #include "algorithm.hpp"
 #include "common_constants.hpp"
+#include "event_trace.hpp"
+#include "game_analysis.hpp"
+#include "game_observer.hpp"
 #include "game_state.hpp"
+#include "invariant_check.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
 #include "safe_numeric.hpp"
@@ -26,11 +33,18 @@ namespace monopoly {
 	}
 
 	inline void do_round(game_state_t& game_state, player_strategies_t& strategies, random_t& random,
-			std::array<unsigned, player_count> const& player_order) {
+			std::array<unsigned, player_count> const& player_order,
+			invariant_check_t const* const invariant_check = nullptr, turn_hook_t* const turn_hook = nullptr) {
 		for (auto const player : player_order) {
 			auto& player_state = game_state.players[player];
 			if (!player_state.is_bankrupt()) {
 				do_turn(game_state, strategies, random, player);
+				if (invariant_check != nullptr) {
+					invariant_check->after_turn(game_state, player);
+				}
+				if (turn_hook != nullptr) {
+					turn_hook->after_turn(game_state, player);
+				}
 			}
 		}
 		safe_uint_add(game_state.round, 1u);
@@ -53,25 +67,56 @@ namespace monopoly {
 	}
 
 
+	// The per-game counters are narrow, so must be flushed periodically during long games.
+	inline void flush_game_stats_if_due(game_state_t& game_state) {
+		if (game_state.round % game_stat_counters_t::flush_interval_rounds == 0) {
+			scoped_phase_timer const timer{profile_phase_t::stats};
+			flush_game_stats(game_state.stats);
+		}
+	}
+
+	// Records the statistics of a finished game.
+	inline void record_game_end(game_state_t& game_state) {
+		scoped_phase_timer const timer{profile_phase_t::stats};
+		flush_game_stats(game_state.stats);
+		record_round_series(game_state);
+		if constexpr (record_stats) {
+			stat_counters.games++;
+			stat_counters.rounds += game_state.round;
+			stat_counters.game_length_histogram.add(game_state.round);
+			stat_counters.game_length_moments.add(game_state.round);
+			// Saturated rather than wrapped, so an absurdly long game shows up at the top of the distribution.
+			auto const saturate = [](std::uint64_t const value) {
+				return static_cast<std::uint32_t>(std::min<std::uint64_t>(value, std::numeric_limits<std::uint32_t>::max()));
+			};
+			stat_counters.turns_per_game_sketch.add(saturate(game_state.stats.totals.game_turns));
+			if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+				stat_counters.rent_per_game_sketch.add(saturate(game_state.stats.totals.game_rent_amount));
+			}
+			record_game_cash_flows(game_state.stats.totals);
+		}
+	}
+
+	// If invariant_check is given, the game state is checked after every turn. If turn_hook is given, it's called after
+	// every turn.
 	inline void do_game(game_state_t& game_state, player_strategies_t& strategies, random_t& random,
-			std::optional<unsigned> const max_rounds = std::nullopt) {
+			std::optional<unsigned> const max_rounds = std::nullopt,
+			invariant_check_t const* const invariant_check = nullptr, turn_hook_t* const turn_hook = nullptr) {
 		// Prevent overflow when game_state.round is incremented if max_rounds is large.
 		static_assert(std::numeric_limits<decltype(max_rounds)::value_type>::max()
 			<= std::numeric_limits<decltype(game_state_t::round)>::max());
 
 		while (true) {
+			record_round_series(game_state);
 			auto const player_order = generate_player_order(random);
-			do_round(game_state, strategies, random, player_order);
+			do_round(game_state, strategies, random, player_order, invariant_check, turn_hook);
 			if (is_game_done(game_state, max_rounds)) {
 				break;
 			}
+			flush_game_stats_if_due(game_state);
 		}
 
-		if constexpr (record_stats) {
-			stat_counters.games++;
-			stat_counters.rounds += game_state.round;
-			stat_counters.game_length_histogram.add(game_state.round);
-		}
+		record_game_end(game_state);
 	}
 
 
@@ -82,11 +127,15 @@ namespace monopoly {
 	}
 
 
+	// If event_trace is given, the game's events are recorded to it.
 	inline void run_new_game(game_state_t& game_state, player_strategies_t& strategies, random_t& random,
-			std::optional<unsigned> const max_rounds = std::nullopt) {
+			std::optional<unsigned> const max_rounds = std::nullopt,
+			invariant_check_t const* const invariant_check = nullptr, event_trace_t* const event_trace = nullptr,
+			turn_hook_t* const turn_hook = nullptr) {
 		reset_for_new_game(game_state, random);
+		game_state.event_trace = event_trace;
 		strategies = player_strategies_t{};
-		do_game(game_state, strategies, random, max_rounds);
+		do_game(game_state, strategies, random, max_rounds, invariant_check, turn_hook);
 	}
 
 }
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "game_state.hpp"
+
+
+// Hooks into seeded games which are called by whichever engine plays them (run_seeded_simulations() or
+// interleaved_game_t), so e.g. determinism checks see exactly what each engine does.
+namespace monopoly {
+
+	// Called after every turn of one game.
+	class turn_hook_t {
+	public:
+		virtual void after_turn(game_state_t const& game_state, unsigned player) = 0;
+
+	protected:
+		~turn_hook_t() = default;
+	};
+
+	// Observes every seeded game. Must be thread safe, since games are played on several threads.
+	class seeded_game_observer_t {
+	public:
+		// Hook for the turns of the game, or nullptr.
+		[[nodiscard]]
+		virtual turn_hook_t* turn_hook(std::uint64_t game) = 0;
+
+		// Called once the game has finished and its statistics are recorded.
+		virtual void after_game(std::uint64_t game, game_state_t const& game_state) = 0;
+
+	protected:
+		~seeded_game_observer_t() = default;
+	};
+
+	// Set before starting simulation threads.
+	inline seeded_game_observer_t* seeded_game_observer = nullptr;
+
+}
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "common_constants.hpp"
+#include "game_analysis.hpp"
+#include "game_state.hpp"
+#include "spsc_ring.hpp"
+#include "stat_counters_io.hpp"
+
+
+// Per-game results written to a binary file without stalling the simulation threads on I/O.
+// Each simulation thread pushes records into its own ring, which a writer thread drains to the file.
+//
+// File layout (little endian):
+//   "MONOGAME", version (u32), player count (u32), then records until the end of the file.
+// Records are grouped by thread and are not in game order.
+namespace monopoly {
+
+	struct game_record_t {
+		std::uint64_t game;
+		std::uint64_t seed;
+		std::uint32_t rounds;
+		std::array<std::uint32_t, player_count> ranks;
+		std::array<std::uint64_t, player_count> net_worths;
+	};
+
+	[[nodiscard]]
+	inline game_record_t make_game_record(game_state_t const& game_state, std::uint64_t const game,
+			std::uint64_t const seed) {
+		game_record_t record{game, seed, game_state.round, {}, {}};
+		auto const ranks = rank_players(game_state);
+		auto const net_worths = player_net_worths(game_state);
+		for (auto const player : players) {
+			record.ranks[player] = ranks[player];
+			record.net_worths[player] = net_worths[player];
+		}
+		return record;
+	}
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, game_record_t>
+	void transfer(Archive& archive, T& record) {
+		transfer(archive, record.game);
+		transfer(archive, record.seed);
+		transfer(archive, record.rounds);
+		transfer(archive, record.ranks);
+		transfer(archive, record.net_worths);
+	}
+
+
+	inline constexpr std::array<char, 8> game_output_file_magic{'M', 'O', 'N', 'O', 'G', 'A', 'M', 'E'};
+
+	// Must be incremented whenever the layout of game_record_t or the file changes.
+	inline constexpr std::uint32_t game_output_file_version = 1;
+
+
+	// What a simulation thread does when the writer can't keep up.
+	enum class game_output_policy_t {
+		// Wait for space, slowing the simulation to the speed of the writer. No records are lost.
+		block,
+		// Discard the record and count it. The simulation is never slowed.
+		drop
+	};
+
+
+	class game_output_writer_t {
+	public:
+		static constexpr std::size_t ring_capacity = 4096;
+
+		// Handle for one simulation thread to push records.
+		class producer_t {
+		public:
+			void push(game_record_t const& record) {
+				while (!_ring.try_push(record)) {
+					if (_policy == game_output_policy_t::drop) {
+						_dropped.fetch_add(1, std::memory_order_relaxed);
+						return;
+					}
+					std::this_thread::yield();
+				}
+			}
+
+		private:
+			friend class game_output_writer_t;
+
+			explicit producer_t(game_output_policy_t const policy) noexcept :
+				_policy{policy}
+			{}
+
+			spsc_ring_t<game_record_t, ring_capacity> _ring;
+			game_output_policy_t _policy;
+			std::atomic<std::uint64_t> _dropped{0};
+		};
+
+		// Opens the file and starts the writer thread. Failure to open the file is reported by finish().
+		game_output_writer_t(std::filesystem::path const& path, unsigned const producer_count,
+				game_output_policy_t const policy) :
+			_stream{path, std::ios::binary | std::ios::trunc}
+		{
+			for (unsigned i = 0; i < producer_count; ++i) {
+				_producers.emplace_back(new producer_t{policy});
+			}
+
+			_stream.write(game_output_file_magic.data(), game_output_file_magic.size());
+			binary_writer_t writer{_stream};
+			transfer(writer, game_output_file_version);
+			transfer(writer, player_count);
+
+			_thread = std::jthread{[this](std::stop_token const stop) {
+				write_loop(stop);
+			}};
+		}
+
+		game_output_writer_t(game_output_writer_t const&) = delete;
+		game_output_writer_t& operator=(game_output_writer_t const&) = delete;
+
+		~game_output_writer_t() {
+			finish();
+		}
+
+		// Each producer must only be used by one thread at a time.
+		[[nodiscard]]
+		producer_t& producer(unsigned const index) noexcept {
+			return *_producers[index];
+		}
+
+		// Writes all remaining records and closes the file. Producers must no longer be in use.
+		// Return value indicates success.
+		bool finish() {
+			if (_thread.joinable()) {
+				_thread.request_stop();
+				_thread.join();
+				_stream.close();
+			}
+			return !_stream.fail();
+		}
+
+		[[nodiscard]]
+		std::uint64_t written_count() const noexcept {
+			return _written;
+		}
+
+		// Records discarded with the drop policy.
+		[[nodiscard]]
+		std::uint64_t dropped_count() const noexcept {
+			std::uint64_t dropped = 0;
+			for (auto const& producer : _producers) {
+				dropped += producer->_dropped.load(std::memory_order_relaxed);
+			}
+			return dropped;
+		}
+
+	private:
+		std::ofstream _stream;
+		std::vector<std::unique_ptr<producer_t>> _producers;
+		std::uint64_t _written = 0;
+		// Declared last so it's stopped and joined before the other members are destroyed.
+		std::jthread _thread;
+
+		void write_loop(std::stop_token const stop) {
+			binary_writer_t writer{_stream};
+			auto const write_record = [this, &writer](game_record_t const& record) {
+				transfer(writer, record);
+				++_written;
+			};
+
+			while (true) {
+				// Read before draining, so nothing pushed before the stop request can be missed.
+				auto const stopping = stop.stop_requested();
+				std::size_t drained = 0;
+				for (auto& producer : _producers) {
+					drained += producer->_ring.consume(write_record);
+				}
+				if (drained == 0) {
+					if (stopping) {
+						break;
+					}
+					std::this_thread::sleep_for(std::chrono::microseconds{200});
+				}
+			}
+		}
+	};
+
+	// Producer for the current thread's games, if per-game output is enabled.
+	inline thread_local game_output_writer_t::producer_t* game_output_producer = nullptr;
+
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+
+
+namespace monopoly {
+
+	// A contiguous range of game indices.
+	// When running seeded simulations, each game's seed is derived from its index with game_seed().
+	struct game_range_t {
+		std::uint64_t first = 0;
+		std::uint64_t count = 0;
+
+		[[nodiscard]]
+		constexpr std::uint64_t end() const noexcept {
+			return first + count;
+		}
+	};
+
+
+	// Splits a range into part_count contiguous parts of nearly equal size, and returns the part_index'th one.
+	// The parts cover the whole range without overlap.
+	[[nodiscard]]
+	constexpr game_range_t split_game_range(game_range_t const range, std::uint64_t const part_count,
+			std::uint64_t const part_index) noexcept {
+		assert(part_count >= 1);
+		assert(part_index < part_count);
+		auto const base_size = range.count / part_count;
+		auto const remainder = range.count % part_count;
+		// The first `remainder` parts get an extra game.
+		auto const first = range.first + part_index * base_size + std::min(part_index, remainder);
+		auto const count = base_size + (part_index < remainder ? 1u : 0u);
+		return {first, count};
+	}
+
+}
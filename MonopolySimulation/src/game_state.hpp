@@ -16,10 +16,14 @@
 #include "per_propertytype_data.hpp"
 #include "property_constants.hpp"
 #include "safe_numeric.hpp"
+#include "statistics_counters.hpp"
 
 
 namespace monopoly {
 
+	class event_trace_t;
+
+
 	class street_ownership_t {
 	public:
 		constexpr street_ownership_t() noexcept {
@@ -459,10 +463,20 @@ namespace monopoly {
 		get_out_of_jail_free_card_ownership_t get_out_of_jail_free_ownership;
 		unsigned round = 0;
 		turn_state_t turn;
+		// Statistics for this game only, flushed into stat_counters when it ends.
+		game_stat_counters_t stats;
+		// Receives the events of this game, if it's traced (see event_trace.hpp).
+		event_trace_t* event_trace = nullptr;
 
 		game_state_t() = default;
 		game_state_t& operator=(game_state_t&&) = default;
 
+		// Explicit copy, for the rare cases where one is intended (e.g. restoring benchmark inputs).
+		[[nodiscard]]
+		game_state_t clone() const {
+			return *this;
+		}
+
 		template<card_type_t C>
 		[[nodiscard]]
 		constexpr auto& card_deck() noexcept {
@@ -474,6 +488,17 @@ namespace monopoly {
 			}
 		}
 
+		template<card_type_t C>
+		[[nodiscard]]
+		constexpr auto const& card_deck() const noexcept {
+			if constexpr (C == card_type_t::chance) {
+				return chance_deck;
+			}
+			else if constexpr (C == card_type_t::community_chest) {
+				return community_chest_deck;
+			}
+		}
+
 	private:
 		// Copying in other contexts is most likely a mistake.
 		game_state_t(game_state_t const&) = default;
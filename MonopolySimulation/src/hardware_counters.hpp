@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MONOPOLY_HARDWARE_COUNTERS_SUPPORTED 1
+#endif
+
+
+// Per-thread hardware performance counters, read with perf_event_open on Linux.
+// Counting is enabled at runtime (--hardware-counters). If the counters can't be opened (unsupported platform, no
+// PMU in a virtual machine, restricted by perf_event_paranoid) they are simply not recorded.
+namespace monopoly {
+
+#ifdef MONOPOLY_HARDWARE_COUNTERS_SUPPORTED
+	inline constexpr bool hardware_counters_supported = true;
+#else
+	inline constexpr bool hardware_counters_supported = false;
+#endif
+
+	enum class hardware_counter_t : unsigned {
+		instructions,
+		cycles,
+		branch_misses,
+		l1d_misses,
+		llc_misses
+	};
+
+	inline constexpr unsigned hardware_counter_count = 5;
+
+	inline constexpr std::array<std::string_view, hardware_counter_count> hardware_counter_names{
+		"instructions",
+		"cycles",
+		"branch misses",
+		"L1D read misses",
+		"LLC misses"
+	};
+
+	// Set before starting simulation threads to count hardware events.
+	inline bool hardware_counters_enabled = false;
+
+	// Values of each counter which is available.
+	using hardware_counter_values_t = std::array<std::optional<std::uint64_t>, hardware_counter_count>;
+
+
+#ifdef MONOPOLY_HARDWARE_COUNTERS_SUPPORTED
+	namespace hardware_counters_detail {
+
+		// User space events of the calling thread, on any CPU.
+		class thread_counters_t {
+		public:
+			thread_counters_t() noexcept {
+				for (unsigned i = 0; i < hardware_counter_count; ++i) {
+					_fds[i] = open_counter(static_cast<hardware_counter_t>(i));
+				}
+			}
+
+			thread_counters_t(thread_counters_t const&) = delete;
+			thread_counters_t& operator=(thread_counters_t const&) = delete;
+
+			~thread_counters_t() {
+				for (auto const fd : _fds) {
+					if (fd >= 0) {
+						close(fd);
+					}
+				}
+			}
+
+			[[nodiscard]]
+			hardware_counter_values_t read() const noexcept {
+				hardware_counter_values_t values;
+				for (unsigned i = 0; i < hardware_counter_count; ++i) {
+					if (_fds[i] < 0) {
+						continue;
+					}
+					// value, time enabled, time running
+					std::array<std::uint64_t, 3> data{};
+					if (::read(_fds[i], data.data(), sizeof(data)) != sizeof(data)) {
+						continue;
+					}
+					// Scale up if the counter was multiplexed with others.
+					auto const [value, enabled, running] = data;
+					if (running == 0) {
+						values[i] = 0;
+					}
+					else if (running < enabled) {
+						values[i] = static_cast<std::uint64_t>(static_cast<double>(value) * enabled / running);
+					}
+					else {
+						values[i] = value;
+					}
+				}
+				return values;
+			}
+
+		private:
+			std::array<int, hardware_counter_count> _fds{};
+
+			[[nodiscard]]
+			static int open_counter(hardware_counter_t const counter) noexcept {
+				perf_event_attr attr;
+				std::memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = PERF_TYPE_HARDWARE;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				switch (counter) {
+				case hardware_counter_t::instructions: attr.config = PERF_COUNT_HW_INSTRUCTIONS; break;
+				case hardware_counter_t::cycles: attr.config = PERF_COUNT_HW_CPU_CYCLES; break;
+				case hardware_counter_t::branch_misses: attr.config = PERF_COUNT_HW_BRANCH_MISSES; break;
+				case hardware_counter_t::l1d_misses:
+					attr.type = PERF_TYPE_HW_CACHE;
+					attr.config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+						| (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+					break;
+				case hardware_counter_t::llc_misses: attr.config = PERF_COUNT_HW_CACHE_MISSES; break;
+				}
+				auto const fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+				return static_cast<int>(fd);
+			}
+		};
+
+		// Opened on first use by each thread.
+		thread_local inline std::optional<thread_counters_t> thread_counters;
+
+	}
+#endif
+
+	// Current values of the calling thread's counters. None are available if hardware_counters_enabled is false.
+	[[nodiscard]]
+	inline hardware_counter_values_t read_thread_hardware_counters() noexcept {
+#ifdef MONOPOLY_HARDWARE_COUNTERS_SUPPORTED
+		if (hardware_counters_enabled) {
+			auto& counters = hardware_counters_detail::thread_counters;
+			if (!counters.has_value()) {
+				counters.emplace();
+			}
+			return counters->read();
+		}
+#endif
+		return {};
+	}
+
+	// Closes the calling thread's counters, so they are reopened on next use (e.g. in a forked process).
+	inline void reset_thread_hardware_counters() noexcept {
+#ifdef MONOPOLY_HARDWARE_COUNTERS_SUPPORTED
+		hardware_counters_detail::thread_counters.reset();
+#endif
+	}
+
+	// Increase of each counter that is available at both times.
+	[[nodiscard]]
+	inline hardware_counter_values_t hardware_counter_difference(hardware_counter_values_t const& start,
+			hardware_counter_values_t const& end) noexcept {
+		hardware_counter_values_t difference;
+		for (unsigned i = 0; i < hardware_counter_count; ++i) {
+			if (start[i].has_value() && end[i].has_value() && *end[i] >= *start[i]) {
+				difference[i] = *end[i] - *start[i];
+			}
+		}
+		return difference;
+	}
+
+}
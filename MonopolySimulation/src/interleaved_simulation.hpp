@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "common_constants.hpp"
+#include "event_trace.hpp"
+#include "game_analysis.hpp"
+#include "game_core.hpp"
+#include "game_observer.hpp"
+#include "game_output.hpp"
+#include "game_state.hpp"
+#include "invariant_check.hpp"
+#include "player_strategy.hpp"
+#include "random.hpp"
+#include "rare_games.hpp"
+#include "safe_numeric.hpp"
+#include "statistics_counters.hpp"
+#include "turn_logic.hpp"
+
+
+namespace monopoly {
+
+	// One game in progress, as an explicit state machine equivalent to run_new_game() + game_end_analysis().
+	// Allows several independent games to be run on one thread, advancing them round-robin one turn at a time.
+	// Consecutive turns then touch unrelated state, so out-of-order execution can overlap one game's cache misses and
+	// mispredicted branches with another game's work.
+	class interleaved_game_t {
+	public:
+		void start(std::uint64_t const game, std::uint64_t const seed) {
+			_game = game;
+			_seed = seed;
+			_invariant_check = invariant_check_t::sample(game, game, seed);
+			_turn_hook = seeded_game_observer != nullptr ? seeded_game_observer->turn_hook(game) : nullptr;
+			_random = random_t{seed};
+			_stat_helper = stat_helper_state_t{};
+			reset_for_new_game(_game_state, _random);
+			if (is_event_trace_sampled(game)) {
+				_event_trace.begin_game(seed);
+				_game_state.event_trace = &_event_trace;
+			}
+			_strategies = player_strategies_t{};
+			start_round();
+		}
+
+		// Plays the next player's turn. Return value indicates if the game has finished.
+		bool step(std::optional<unsigned> const max_rounds) {
+			// Skip players who went bankrupt before their turn this round, as do_round() does.
+			while (_order_index < player_count && _game_state.players[_player_order[_order_index]].is_bankrupt()) {
+				++_order_index;
+			}
+
+			if (_order_index < player_count) {
+				// Statistics helper state is per game, so swap in this game's.
+				std::swap(stat_helper_state, _stat_helper);
+				do_turn(_game_state, _strategies, _random, _player_order[_order_index]);
+				std::swap(stat_helper_state, _stat_helper);
+				if (_invariant_check.has_value()) {
+					_invariant_check->after_turn(_game_state, _player_order[_order_index]);
+				}
+				if (_turn_hook != nullptr) {
+					_turn_hook->after_turn(_game_state, _player_order[_order_index]);
+				}
+				++_order_index;
+				return false;
+			}
+
+			safe_uint_add(_game_state.round, 1u);
+			if (is_game_done(_game_state, max_rounds)) {
+				record_game_end(_game_state);
+				if (_game_state.event_trace != nullptr) {
+					_event_trace.end_game(_game_state);
+				}
+				game_end_analysis(_game_state);
+				if (seeded_game_observer != nullptr) {
+					seeded_game_observer->after_game(_game, _game_state);
+				}
+				record_rare_game(_game_state, _seed);
+				if (game_output_producer != nullptr) {
+					game_output_producer->push(make_game_record(_game_state, _game, _seed));
+				}
+				return true;
+			}
+			flush_game_stats_if_due(_game_state);
+			start_round();
+			return false;
+		}
+
+		[[nodiscard]]
+		game_state_t const& game_state() const noexcept {
+			return _game_state;
+		}
+
+	private:
+		game_state_t _game_state;
+		player_strategies_t _strategies;
+		random_t _random{1};
+		stat_helper_state_t _stat_helper{};
+		std::array<unsigned, player_count> _player_order{};
+		unsigned _order_index = 0;
+		std::uint64_t _game = 0;
+		std::uint64_t _seed = 0;
+		std::optional<invariant_check_t> _invariant_check;
+		turn_hook_t* _turn_hook = nullptr;
+		// Each game in progress needs its own trace, since the thread's is for games played one at a time.
+		event_trace_t _event_trace;
+
+		void start_round() {
+			record_round_series(_game_state);
+			_player_order = generate_player_order(_random);
+			_order_index = 0;
+		}
+	};
+
+}
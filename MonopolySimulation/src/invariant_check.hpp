@@ -0,0 +1,220 @@
+#pragma once
+
+#include <array>
+#include <bitset>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <type_traits>
+
+#include "card_constants.hpp"
+#include "common_constants.hpp"
+#include "common_types.hpp"
+#include "game_state.hpp"
+#include "gameplay_constants.hpp"
+#include "property_constants.hpp"
+
+
+// Consistency checks of the whole game state, which run after every turn of a sample of games, in any build.
+// They cover what the asserts throughout the game logic check, which only run in debug builds, and are too slow for
+// large runs. Sampling is enabled at runtime (--check-invariants N); when disabled, each turn only checks for a null
+// pointer.
+namespace monopoly {
+
+	// 1 in this many games is checked, 0 = none. Set before starting simulation threads.
+	inline std::uint64_t invariant_check_interval = 0;
+
+	namespace invariant_check_detail {
+
+		template<card_type_t C>
+		[[nodiscard]]
+		std::optional<std::string> find_deck_violation(game_state_t const& game_state) {
+			auto const& deck = game_state.card_deck<C>();
+			// Short enough not to allocate.
+			std::string const deck_name{C == card_type_t::chance ? "Chance" : "Community Chest"};
+
+			// Every card exactly once.
+			std::bitset<std::remove_cvref_t<decltype(deck)>::size> seen;
+			for (auto const card : deck.cards) {
+				auto const index = static_cast<unsigned>(card);
+				if (index >= deck.size || seen[index]) {
+					return deck_name + " deck isn't a permutation of the cards";
+				}
+				seen[index] = true;
+			}
+			if (deck.top_index >= deck.size) {
+				return deck_name + " deck top index out of range";
+			}
+
+			// While drawn, Get Out Of Jail Free stays in the deck at the index it was drawn from, and is skipped.
+			auto const owner = game_state.get_out_of_jail_free_ownership.get_owner(C);
+			if (owner.has_value()) {
+				auto const index = deck.get_out_of_jail_free_index;
+				if (!index.has_value() || *index >= deck.size
+						|| deck.cards[*index] != get_out_of_jail_free_card<C>) {
+					return deck_name + " Get Out Of Jail Free card is owned but not tracked in the deck";
+				}
+				if (*owner >= player_count || game_state.players[*owner].is_bankrupt()) {
+					return deck_name + " Get Out Of Jail Free card owned by bankrupt or invalid player "
+						+ std::to_string(*owner);
+				}
+			}
+			return std::nullopt;
+		}
+
+	}
+
+	// Description of the first inconsistency found in the game state, or nullopt if there is none.
+	[[nodiscard]]
+	inline std::optional<std::string> find_invariant_violation(game_state_t const& game_state) {
+		using namespace std::string_literals;
+
+		std::array<unsigned, player_count> houses{};
+		std::array<unsigned, player_count> hotels{};
+		std::array<unsigned, player_count> properties{};
+		// Names are only built for the violation, since this runs after every turn.
+		auto const check_owner = [&properties](std::optional<unsigned> const owner, bool const mortgaged,
+				auto const& name) -> std::optional<std::string> {
+			if (!owner.has_value()) {
+				if (mortgaged) {
+					return name() + " is mortgaged but unowned";
+				}
+				return std::nullopt;
+			}
+			if (*owner >= player_count) {
+				return name() + " is owned by invalid player " + std::to_string(*owner);
+			}
+			++properties[*owner];
+			return std::nullopt;
+		};
+
+		for (auto const& street : streets) {
+			auto const name = [street] { return "street "s + std::to_string(street.generic_index); };
+			auto const level = game_state.street_development.development_level(street);
+			if (level < -1 || level > 5) {
+				return name() + " has development level " + std::to_string(level);
+			}
+			auto const owner = game_state.property_ownership.street.get_owner(street);
+			if (auto violation = check_owner(owner, level < 0, name)) {
+				return violation;
+			}
+			if (level <= 0) {
+				continue;
+			}
+
+			// Buildings require the whole colour set, evenly developed with nothing mortgaged.
+			if (!owner.has_value() || !game_state.property_ownership.street.owns_entire_colour_set(*owner,
+					street.colour_set)) {
+				return name() + " has buildings without its owner having the colour set";
+			}
+			auto const min_level = game_state.street_development.min_development_level_in_set(street.colour_set);
+			if (min_level < 0) {
+				return name() + " has buildings while its colour set has a mortgaged street";
+			}
+			if (level - min_level > 1) {
+				return name() + " has uneven buildings within its colour set";
+			}
+			if (level == 5) {
+				++hotels[*owner];
+			}
+			else {
+				houses[*owner] += static_cast<unsigned>(level);
+			}
+		}
+		for (auto const railway : railways) {
+			auto const name = [railway] { return "railway "s + std::to_string(static_cast<unsigned>(railway)); };
+			if (auto violation = check_owner(game_state.property_ownership.railway.get_owner(railway),
+					game_state.railway_development.is_mortgaged(railway), name)) {
+				return violation;
+			}
+		}
+		for (auto const utility : utilities) {
+			auto const name = [utility] { return "utility "s + std::to_string(static_cast<unsigned>(utility)); };
+			if (auto violation = check_owner(game_state.property_ownership.utility.get_owner(utility),
+					game_state.utility_development.is_mortgaged(utility), name)) {
+				return violation;
+			}
+		}
+
+		unsigned bankrupt_count = 0;
+		for (auto const player : players) {
+			auto const& player_state = game_state.players[player];
+			auto const name = "player "s + std::to_string(player);		// Short enough not to allocate.
+			if (player_state.position < -static_cast<int>(max_turns_in_jail)
+					|| player_state.position >= static_cast<int>(board_space_count)) {
+				return name + " has position " + std::to_string(player_state.position);
+			}
+			if (player_state.consecutive_doubles >= consecutive_doubles_jail_threshold) {
+				return name + " has " + std::to_string(player_state.consecutive_doubles) + " consecutive doubles";
+			}
+			if (player_state.houses_owned != houses[player] || player_state.hotels_owned != hotels[player]) {
+				return name + " building counts don't match their streets";
+			}
+			if (!player_state.is_bankrupt()) {
+				continue;
+			}
+			++bankrupt_count;
+			// A bankrupt player has no net worth.
+			if (player_state.cash != 0 || properties[player] != 0) {
+				return name + " is bankrupt but has cash or properties";
+			}
+			if (*player_state.bankrupt_round > game_state.round) {
+				return name + " went bankrupt in a future round";
+			}
+		}
+		if (bankrupt_count >= player_count) {
+			return "every player is bankrupt"s;
+		}
+
+		if (auto violation = invariant_check_detail::find_deck_violation<card_type_t::chance>(game_state)) {
+			return violation;
+		}
+		return invariant_check_detail::find_deck_violation<card_type_t::community_chest>(game_state);
+	}
+
+
+	// Checks the state of one game after each turn.
+	class invariant_check_t {
+	public:
+		// game is the game's index in the run, if it has one, and seed is that of the game's random_t, so the game can be
+		// replayed (--replay-game).
+		constexpr invariant_check_t(std::optional<std::uint64_t> const game, std::uint64_t const seed) noexcept :
+			_game{game},
+			_seed{seed}
+		{}
+
+		// The check for a game, or nullopt if the game isn't sampled. Seeded games are sampled by their index in the
+		// run, so the same games are checked however the run is split between threads and processes; unseeded games by
+		// unseeded_sample_index().
+		[[nodiscard]]
+		static std::optional<invariant_check_t> sample(std::uint64_t const sample_index,
+				std::optional<std::uint64_t> const game, std::uint64_t const seed) noexcept {
+			if (invariant_check_interval == 0 || sample_index % invariant_check_interval != 0) {
+				return std::nullopt;
+			}
+			return invariant_check_t{game, seed};
+		}
+
+		// Reports the first violation and aborts, like a failed assert.
+		void after_turn(game_state_t const& game_state, unsigned const player) const {
+			auto const violation = find_invariant_violation(game_state);
+			if (!violation.has_value()) [[likely]] {
+				return;
+			}
+			std::cerr << "Invariant violated: " << *violation << "\n  ";
+			if (_game.has_value()) {
+				std::cerr << "game " << *_game << ", ";
+			}
+			std::cerr << "seed " << _seed << ", round " << game_state.round << ", after the turn of player " << player
+				<< std::endl;
+			std::abort();
+		}
+
+	private:
+		std::optional<std::uint64_t> _game;
+		std::uint64_t _seed;
+	};
+
+}
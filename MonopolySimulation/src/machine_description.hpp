@@ -0,0 +1,114 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MONOPOLY_HAS_CPUID 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define MONOPOLY_HAS_CPUID 1
+#endif
+
+
+// Description of the machine and build, recorded with benchmark results so they are only compared like for like.
+namespace monopoly {
+
+	struct machine_description_t {
+		std::string cpu;
+		unsigned hardware_threads = 0;
+		std::string compiler;
+		std::string build;
+	};
+
+	// CPU brand string, or "unknown".
+	[[nodiscard]]
+	inline std::string cpu_brand_string() {
+#ifdef MONOPOLY_HAS_CPUID
+		auto const cpuid = [](unsigned const leaf) {
+			std::array<unsigned, 4> registers{};
+#ifdef _MSC_VER
+			std::array<int, 4> values{};
+			__cpuid(values.data(), static_cast<int>(leaf));
+			std::memcpy(registers.data(), values.data(), sizeof(registers));
+#else
+			__cpuid(leaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+			return registers;
+		};
+
+		if (cpuid(0x80000000u)[0] >= 0x80000004u) {
+			std::array<char, 48> brand{};
+			for (unsigned i = 0; i < 3; ++i) {
+				auto const registers = cpuid(0x80000002u + i);
+				std::memcpy(brand.data() + i * sizeof(registers), registers.data(), sizeof(registers));
+			}
+			std::string result{brand.begin(), std::ranges::find(brand, '\0')};
+			// Brand strings are often padded with spaces.
+			auto const first = result.find_first_not_of(' ');
+			auto const last = result.find_last_not_of(' ');
+			if (first != std::string::npos) {
+				return result.substr(first, last - first + 1);
+			}
+		}
+#endif
+		return "unknown";
+	}
+
+	[[nodiscard]]
+	inline machine_description_t describe_machine() {
+		machine_description_t description;
+		description.cpu = cpu_brand_string();
+		description.hardware_threads = std::thread::hardware_concurrency();
+#if defined(__clang__)
+		description.compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+		description.compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+		description.compiler = "msvc " + std::to_string(_MSC_FULL_VER);
+#else
+		description.compiler = "unknown";
+#endif
+#ifdef NDEBUG
+		description.build = "release";
+#else
+		description.build = "debug";
+#endif
+		return description;
+	}
+
+	// Writes str as a JSON string literal.
+	inline void write_json_string(std::ostream& stream, std::string_view const str) {
+		stream << '"';
+		for (auto const c : str) {
+			if (c == '"' || c == '\\') {
+				stream << '\\' << c;
+			}
+			else if (static_cast<unsigned char>(c) < 0x20) {
+				stream << ' ';
+			}
+			else {
+				stream << c;
+			}
+		}
+		stream << '"';
+	}
+
+	// Writes the description as a JSON object.
+	inline void write_machine_description_json(std::ostream& stream, machine_description_t const& description) {
+		stream << "{\"cpu\": ";
+		write_json_string(stream, description.cpu);
+		stream << ", \"hardware_threads\": " << description.hardware_threads << ", \"compiler\": ";
+		write_json_string(stream, description.compiler);
+		stream << ", \"build\": ";
+		write_json_string(stream, description.build);
+		stream << '}';
+	}
+
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "game_range.hpp"
+#include "machine_description.hpp"
+#include "math.hpp"
+#include "player_strategy.hpp"
+#include "simulation.hpp"
+#include "statistics_counters.hpp"
+
+
+// End-to-end benchmark of fixed seeded workloads, with results saved as JSON and compared against a baseline to catch
+// throughput regressions.
+// Workloads which need a different build (statistics disabled, all players always rolling in jail) are named after
+// the build variant, so each build is only compared with baseline results of the same variant.
+namespace monopoly {
+
+	struct macro_workload_t {
+		std::string_view name;
+		std::uint32_t max_rounds;
+		// Relative to the benchmark's game count.
+		std::uint64_t game_count_divisor;
+	};
+
+	inline constexpr std::array<macro_workload_t, 2> macro_workloads{{
+		{"default", 100, 1},
+		// Ten times the round limit, so the late game dominates.
+		{"long_games", 1000, 10}
+	}};
+
+	// Describes the build configuration which affects the workloads, e.g. "stats_off+always_roll_jail".
+	[[nodiscard]]
+	inline std::string macro_benchmark_variant() {
+		std::string variant;
+		auto const add = [&variant](std::string_view const name) {
+			if (!variant.empty()) {
+				variant += '+';
+			}
+			variant += name;
+		};
+		if constexpr (!record_stats) {
+			add("stats_off");
+		}
+		if constexpr (always_roll_jail) {
+			add("always_roll_jail");
+		}
+		return variant.empty() ? "standard" : variant;
+	}
+
+	struct macro_benchmark_result_t {
+		std::string name;
+		std::uint64_t games = 0;
+		std::uint64_t turns = 0;
+		// Wall time of the fastest repetition.
+		double seconds = 0;
+
+		[[nodiscard]]
+		double games_per_second() const {
+			return div(games, seconds);
+		}
+
+		[[nodiscard]]
+		double turns_per_second() const {
+			return div(turns, seconds);
+		}
+
+		[[nodiscard]]
+		double ns_per_turn() const {
+			return div(seconds * 1e9, turns);
+		}
+	};
+
+	// Runs each workload repetitions times, keeping the fastest, which is the least disturbed by other activity.
+	[[nodiscard]]
+	inline std::vector<macro_benchmark_result_t> run_macro_benchmark(std::uint64_t const base_seed,
+			std::uint64_t const game_count, unsigned const threads, unsigned const repetitions) {
+		auto const strategies_factory = [] {
+			return player_strategies_t{};
+		};
+		auto const variant = macro_benchmark_variant();
+
+		std::vector<macro_benchmark_result_t> results;
+		for (auto const& workload : macro_workloads) {
+			game_range_t const games{0, std::max<std::uint64_t>(game_count / workload.game_count_divisor, 1)};
+			macro_benchmark_result_t result{.name = variant + '/' + std::string{workload.name},
+				.games = games.count};
+			for (unsigned repetition = 0; repetition < repetitions; ++repetition) {
+				auto const start_time = std::chrono::steady_clock::now();
+				run_seeded_simulations_multithreaded(strategies_factory, base_seed, games, workload.max_rounds,
+					threads);
+				std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start_time;
+				if (repetition == 0 || elapsed.count() < result.seconds) {
+					result.seconds = elapsed.count();
+				}
+				// Seeded, so every repetition plays the same turns.
+				result.turns = sum(stat_counters.turns_played);
+			}
+			results.push_back(std::move(result));
+		}
+		return results;
+	}
+
+	// One workload per line, which read_macro_benchmark_baseline() relies on.
+	inline void write_macro_benchmark_json(std::ostream& stream, machine_description_t const& machine,
+			unsigned const threads, std::vector<macro_benchmark_result_t> const& results) {
+		stream.precision(6);
+		stream << "{\n\t\"machine\": ";
+		write_machine_description_json(stream, machine);
+		stream << ",\n\t\"threads\": " << threads << ",\n\t\"workloads\": [";
+		for (std::size_t i = 0; i < results.size(); ++i) {
+			auto const& result = results[i];
+			stream << (i == 0 ? "\n" : ",\n") << "\t\t{\"name\": ";
+			write_json_string(stream, result.name);
+			stream << ", \"games\": " << result.games << ", \"turns\": " << result.turns << ", \"seconds\": "
+				<< result.seconds << ", \"games_per_second\": " << result.games_per_second()
+				<< ", \"turns_per_second\": " << result.turns_per_second() << ", \"ns_per_turn\": "
+				<< result.ns_per_turn() << '}';
+		}
+		stream << "\n\t]\n}\n";
+	}
+
+	struct macro_baseline_t {
+		struct workload_t {
+			std::string name;
+			double turns_per_second = 0;
+		};
+
+		std::string cpu;
+		unsigned threads = 0;
+		std::vector<workload_t> workloads;
+	};
+
+	namespace macro_benchmark_detail {
+
+		// Raw text of the value of "key" in a single line JSON object, e.g. `"abc"` or `1.5`.
+		[[nodiscard]]
+		inline std::optional<std::string_view> find_json_value(std::string_view const line,
+				std::string_view const key) {
+			auto const quoted_key = '"' + std::string{key} + "\": ";
+			auto const key_pos = line.find(quoted_key);
+			if (key_pos == std::string_view::npos) {
+				return std::nullopt;
+			}
+			auto const value = line.substr(key_pos + quoted_key.size());
+			if (value.starts_with('"')) {
+				auto const end = value.find('"', 1);
+				return end == std::string_view::npos ? std::nullopt : std::optional{value.substr(1, end - 1)};
+			}
+			return value.substr(0, value.find_first_of(",}"));
+		}
+
+	}
+
+	// Reads the results of a file written by write_macro_benchmark_json(). nullopt if it can't be read.
+	[[nodiscard]]
+	inline std::optional<macro_baseline_t> read_macro_benchmark_baseline(std::filesystem::path const& path) {
+		std::ifstream stream{path};
+		if (!stream) {
+			return std::nullopt;
+		}
+		macro_baseline_t baseline;
+		std::string line;
+		while (std::getline(stream, line)) {
+			if (auto const cpu = macro_benchmark_detail::find_json_value(line, "cpu"); cpu.has_value()) {
+				baseline.cpu = *cpu;
+			}
+			if (auto const threads = macro_benchmark_detail::find_json_value(line, "threads"); threads.has_value()) {
+				auto const [end, error] = std::from_chars(threads->data(), threads->data() + threads->size(),
+					baseline.threads);
+				if (error != std::errc{} || baseline.threads == 0) {
+					return std::nullopt;
+				}
+			}
+			auto const name = macro_benchmark_detail::find_json_value(line, "name");
+			auto const turns_per_second = macro_benchmark_detail::find_json_value(line, "turns_per_second");
+			if (!name.has_value() || !turns_per_second.has_value()) {
+				continue;
+			}
+			macro_baseline_t::workload_t workload{std::string{*name}};
+			auto const [end, error] = std::from_chars(turns_per_second->data(),
+				turns_per_second->data() + turns_per_second->size(), workload.turns_per_second);
+			if (error != std::errc{} || workload.turns_per_second <= 0) {
+				return std::nullopt;
+			}
+			baseline.workloads.push_back(std::move(workload));
+		}
+		if (baseline.threads == 0) {
+			return std::nullopt;
+		}
+		return baseline;
+	}
+
+}
@@ -1,28 +1,255 @@
 #include <array>
+#include <chrono>
 #include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <optional>
 #include <random>
 #include <ranges>
+#include <span>
+#include <string>
 
 #include "algorithm.hpp"
 #include "board_space_names.hpp"
+#include "checkpoint.hpp"
+#include "command_line.hpp"
 #include "common_types.hpp"
+#include "convergence.hpp"
+#include "cpu_time.hpp"
+#include "determinism_check.hpp"
+#include "event_trace.hpp"
+#include "game_output.hpp"
+#include "game_range.hpp"
+#include "hardware_counters.hpp"
+#include "invariant_check.hpp"
+#include "machine_description.hpp"
+#include "macro_benchmark.hpp"
+#include "math.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
+#include "process_pool.hpp"
 #include "random.hpp"
+#include "rare_games.hpp"
+#include "scaling_benchmark.hpp"
 #include "simulation.hpp"
+#include "stat_counters_export.hpp"
+#include "stat_counters_io.hpp"
+#include "stat_counters_merge.hpp"
 #include "statistics.hpp"
 #include "statistics_counters.hpp"
+#include "work_queue.hpp"
 
 
 namespace monopoly {
 
-	void print_statistics(stat_counters_t const& stat_counters) {
+#if defined(NDEBUG) || defined(RELEASE)
+	constexpr std::size_t default_game_count = 1'000'000;
+#else
+	constexpr std::size_t default_game_count = 1000;
+#endif
+
+	// Writes the counters to the --export-csv and --export-json files, if given.
+	// Return value indicates success.
+	bool export_statistics(program_options_t const& options, stat_counters_t const& counters) {
+		auto const export_to = [&counters](std::optional<std::filesystem::path> const& path,
+				stat_export_format_t const format) {
+			if (path.has_value() && !export_stat_counters(*path, format, counters)) {
+				std::cerr << "Error: failed to write " << *path << '\n';
+				return false;
+			}
+			return true;
+		};
+		return export_to(options.export_csv_file, stat_export_format_t::csv)
+			&& export_to(options.export_json_file, stat_export_format_t::json);
+	}
+
+	// Standard error, 95% confidence interval and range of the mean of a per-game quantity.
+	void print_mean_interval(moment_accumulator const& moments) {
+		static double const z = normal_two_sided_quantile(0.95);
+		auto const half_width = z * moments.standard_error();
+		std::cout << " (SE " << moments.standard_error() << ", 95% CI " << moments.mean - half_width << " to "
+			<< moments.mean + half_width << ", range " << moments.min << " to " << moments.max << ')';
+	}
+
+	// Quantiles of a log_linear_histogram. Each is the upper end of its bin, so accurate to within the bin width.
+	void print_quantiles(auto const& histogram) {
+		std::cout << "p50 " << histogram.value_at_quantile(0.5) << ", p90 " << histogram.value_at_quantile(0.9)
+			<< ", p99 " << histogram.value_at_quantile(0.99) << ", p99.9 " << histogram.value_at_quantile(0.999)
+			<< " (" << histogram.count() << " samples)";
+	}
+
+	void print_quantiles(quantile_summary_t const& quantiles) {
+		std::cout << "p50 " << quantiles.p50 << ", p90 " << quantiles.p90 << ", p99 " << quantiles.p99;
+	}
+
+	// Average state of the games after every 10 rounds. Averages are over the games which lasted that long, so later
+	// rounds are biased towards longer games.
+	// The final row covers every round from round_series_length on, so it has a sample per game per round.
+	void print_round_series(stat_counters_t const& stat_counters) {
+		constexpr unsigned round_step = 10;
+		auto const flags = std::cout.flags();
+		auto const precision = std::cout.precision();
+
+		std::cout << "Avg state after each round (all players, and net worth per player):\n";
+		std::cout << std::left << std::setw(9) << "  round" << std::setw(10) << "samples" << std::setw(10) << "cash"
+			<< std::setw(11) << "net worth" << std::setw(12) << "properties" << std::setw(10) << "bankrupt%";
+		for (auto const player : players) {
+			std::cout << "P" << std::setw(8) << player;
+		}
+		std::cout << '\n';
+
+		for (unsigned index = 0; index <= round_series_length; ++index) {
+			auto const games = stat_counters.round_series_games[index];
+			if (games == 0 || (index % round_step != 0 && index != round_series_length)) {
+				continue;
+			}
+			// Average over players and games.
+			auto const average = [games](auto const& series, unsigned const i) {
+				int_count total = 0;
+				for (auto const player : players) {
+					total += series[player][i];
+				}
+				return div(total, games * player_count);
+			};
+
+			std::cout << "  " << std::setw(7);
+			if (index < round_series_length) {
+				std::cout << index;
+			}
+			else {
+				std::cout << std::to_string(index) + "+";
+			}
+			std::cout << std::setw(10) << games << std::fixed << std::setprecision(1)
+				<< std::setw(10) << average(stat_counters.round_series_cash, index)
+				<< std::setw(11) << average(stat_counters.round_series_net_worth, index)
+				<< std::setprecision(2) << std::setw(12) << average(stat_counters.round_series_property_count, index)
+				<< std::setw(10) << average(stat_counters.round_series_bankrupt_count, index) * 100
+				<< std::setprecision(1);
+			for (auto const player : players) {
+				std::cout << std::setw(9) << div(stat_counters.round_series_net_worth[player][index], games);
+			}
+			std::cout << '\n';
+		}
+		std::cout << '\n';
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	// Win rate and average rank with and without each cohort feature, over all players.
+	void print_cohorts(statistics_t const& statistics) {
+		auto const win_rate = [](per_player_int_count const& rank_counts) {
+			return div(rank_counts[0], sum(rank_counts));
+		};
+		auto const avg_rank = [](per_player_int_count const& rank_counts) {
+			int_count rank_total = 0;
+			for (unsigned rank = 0; rank < player_count; ++rank) {
+				rank_total += rank * rank_counts[rank];
+			}
+			return div(rank_total, sum(rank_counts));
+		};
+
+		auto const flags = std::cout.flags();
+		auto const precision = std::cout.precision();
+
+		std::cout << "Cohorts (all players, win = rank 0 including ties):\n";
+		std::cout << std::left << std::setw(30) << "  feature" << std::setw(10) << "share%" << std::setw(18)
+			<< "win% with/without" << "avg rank with/without\n";
+		std::cout << std::fixed;
+		for (unsigned feature = 0; feature < cohort_feature_count; ++feature) {
+			if (!record_stat_group<stat_group_t::movement>
+					&& cohort_feature_needs_movement(static_cast<cohort_feature_t>(feature))) {
+				std::cout << "  " << std::setw(28) << cohort_feature_names[feature]
+					<< "not recorded (needs the movement group)\n";
+				continue;
+			}
+			auto const bit = cohort_feature_bit(static_cast<cohort_feature_t>(feature));
+			auto const with = statistics.cohort_rank_counts(bit, 0);
+			auto const without = statistics.cohort_rank_counts(0, bit);
+			std::cout << "  " << std::setw(28) << cohort_feature_names[feature] << std::setprecision(2)
+				<< std::setw(10) << div(sum(with), sum(with) + sum(without)) * 100
+				<< std::setw(7) << win_rate(with) * 100 << std::setw(11) << win_rate(without) * 100
+				<< std::setprecision(3) << std::setw(7) << avg_rank(with) << avg_rank(without) << '\n';
+		}
+		std::cout << '\n';
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	// Time per phase of the turn loop, as a proportion of total turn time. Self time excludes nested phases.
+	void print_phase_profile(phase_profile_t const& profile) {
+		auto const turn_index = static_cast<unsigned>(profile_phase_t::turn);
+		auto const turn_cycles = static_cast<double>(profile.cycles[turn_index]);
+		auto const flags = std::cout.flags();
+		auto const precision = std::cout.precision();
+		std::cout << "Phase profile (cycles):\n"
+			<< "  Phase             Calls  Cycles/call  Inclusive %   Self %\n"
+			<< std::fixed;
+		for (unsigned phase = 0; phase < profile_phase_count; ++phase) {
+			auto const calls = profile.calls[phase];
+			std::cout << "  " << std::left << std::setw(12) << profile_phase_names[phase] << std::right
+				<< std::setw(11) << calls
+				<< std::setprecision(1) << std::setw(13) << div(profile.cycles[phase], calls)
+				<< std::setprecision(2) << std::setw(13) << div(profile.cycles[phase], turn_cycles) * 100
+				<< std::setw(9) << div(profile.self_cycles[phase], turn_cycles) * 100 << '\n';
+		}
+		std::cout << '\n';
+		std::cout.flags(flags);
+		std::cout.precision(precision);
+	}
+
+	void print_rare_game(rare_game_t const& game) {
+		auto const optional = [](auto const& value) {
+			return value.has_value() ? std::to_string(*value) : std::string{"-"};
+		};
+		std::cout << "  " << std::setw(20) << game.seed << std::setw(8) << game.rounds << std::setw(8)
+			<< optional(game.turns) << std::setw(12) << optional(game.first_bankruptcy_round) << std::setw(10)
+			<< optional(game.max_rent_payment) << std::setw(10) << optional(game.winner_comeback) << '\n';
+	}
+
+	void print_rare_game_header() {
+		std::cout << "                  seed  rounds   turns  bankruptcy  max rent  comeback\n";
+	}
+
+	// Most extreme games first. Replay one with --replay-game SEED.
+	void print_rare_games(rare_game_reservoir_t const& reservoir) {
+		std::cout << "Rare games (replay with --replay-game SEED):\n";
+		for (unsigned i = 0; i < rare_game_criterion_count; ++i) {
+			if (!rare_game_config.criteria[i]) {
+				continue;
+			}
+			auto const games = reservoir.games(static_cast<rare_game_criterion_t>(i));
+			std::cout << "  " << rare_game_criterion_names[i] << ":\n";
+			if (games.empty()) {
+				std::cout << "    none (no game qualified)\n";
+				continue;
+			}
+			print_rare_game_header();
+			for (auto const& game : games) {
+				print_rare_game(game);
+			}
+		}
+		std::cout << '\n';
+	}
+
+	// wall_seconds is the elapsed time of the run, if known.
+	void print_statistics(stat_counters_t const& stat_counters,
+			std::optional<double> const wall_seconds = std::nullopt) {
 		statistics_t const statistics{stat_counters};
 
 		std::cout << "Games: " << stat_counters.games << "\n\n";
 
-		std::cout << "Avg rounds per game: " << statistics.avg_rounds_per_game() << "\n\n";
+		std::cout << "Avg rounds per game: " << statistics.avg_rounds_per_game();
+		print_mean_interval(stat_counters.game_length_moments);
+		std::cout << "\n\n";
+
+		std::cout << "Turns per game quantiles (all players): ";
+		print_quantiles(statistics.turns_per_game_quantiles());
+		std::cout << "\n\n";
 
 		{
 			std::cout << "Game length histogram:\n";
@@ -41,95 +268,190 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		std::cout << "Avg player ranks:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": " << statistics.avg_player_rank(player) << '\n';
+		if constexpr (record_stat_group<stat_group_t::endgame>) {
+			std::cout << "Avg player ranks:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": " << statistics.avg_player_rank(player);
+				print_mean_interval(stat_counters.player_rank_moments[player]);
+				std::cout << '\n';
+			}
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg final net worths:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": " << statistics.avg_final_net_worth(player) << '\n';
+		if constexpr (record_stat_group<stat_group_t::endgame>) {
+			std::cout << "Avg final net worths:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": " << statistics.avg_final_net_worth(player);
+				print_mean_interval(stat_counters.final_net_worth_moments[player]);
+				std::cout << '\n';
+			}
+			std::cout << '\n';
+
+			std::cout << "Final net worth quantiles:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": ";
+				print_quantiles(stat_counters.final_net_worth_histogram[player]);
+				std::cout << '\n';
+			}
+			std::cout << '\n';
+
+			std::cout << "Cash raised for the payment causing bankruptcy quantiles:\n  ";
+			print_quantiles(stat_counters.bankruptcy_cash_histogram);
+			std::cout << "\n\n";
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg cash income per game breakdown:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ":\n";
-			std::cout << "    " << statistics.avg_go_salary_per_game(player) << " Go salary\n";
-			std::cout << "    " << statistics.avg_rent_received_per_game(player) << " rent\n";
-			std::cout << "    " << statistics.avg_property_sell_income_per_game(player) << " property sale\n";
-			std::cout << "    " << statistics.avg_cash_award_card_amount_per_game(player) << " cash award card\n";
-			std::cout << "    " << statistics.avg_per_player_cash_fee_card_amount_received_per_game(player)
-				<< " per-player cash fee card\n";
+		if constexpr (record_stat_group<stat_group_t::round_series>) {
+			print_round_series(stat_counters);
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg cash expenditure per game breakdown:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ":\n";
-			std::cout << "    " << statistics.avg_tax_space_paid_per_game_approx(player) << " tax space\n";
-			std::cout << "    " << statistics.avg_jail_fee_per_game_approx(player) << " jail fee\n";
-			std::cout << "    " << statistics.avg_rent_paid_per_game(player) << " rent\n";
-			std::cout << "    " << statistics.avg_property_purchase_costs_per_game(player) << " property purchase\n";
-			std::cout << "    " << statistics.avg_cash_fee_card_amount_per_game(player) << " cash fee card\n";
-			std::cout << "    " << statistics.avg_per_player_cash_award_card_amount_paid_per_game(player)
-				<< " per-player cash award card\n";
+		if constexpr (record_stat_group<stat_group_t::cohorts>) {
+			print_cohorts(statistics);
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg times passed Go per turn:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": " << statistics.avg_go_passes_per_turn(player) << '\n';
+		// Each line is only shown if the group it comes from is recorded.
+		constexpr bool movement = record_stat_group<stat_group_t::movement>;
+		constexpr bool cash_flow = record_stat_group<stat_group_t::cash_flow>;
+		constexpr bool cards = record_stat_group<stat_group_t::cards>;
+		constexpr bool property = record_stat_group<stat_group_t::property>;
+
+		if constexpr (movement || cash_flow || cards || property) {
+			auto const print_amount = [](double avg, char const* source, moment_accumulator const& moments) {
+				std::cout << "    " << avg << ' ' << source;
+				print_mean_interval(moments);
+				std::cout << '\n';
+			};
+
+			std::cout << "Avg cash income per game breakdown:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ":\n";
+				if constexpr (movement) {
+					print_amount(statistics.avg_go_salary_per_game(player), "Go salary",
+						stat_counters.go_salary_moments[player]);
+				}
+				if constexpr (cash_flow) {
+					print_amount(statistics.avg_rent_received_per_game(player), "rent",
+						stat_counters.rent_received_moments[player]);
+				}
+				if constexpr (property) {
+					print_amount(statistics.avg_property_sell_income_per_game(player), "property sale",
+						stat_counters.property_sell_income_moments[player]);
+				}
+				if constexpr (cards) {
+					print_amount(statistics.avg_cash_award_card_amount_per_game(player), "cash award card",
+						stat_counters.cash_award_card_amount_moments[player]);
+					print_amount(statistics.avg_per_player_cash_fee_card_amount_received_per_game(player),
+						"per-player cash fee card",
+						stat_counters.per_player_cash_fee_card_receive_amount_moments[player]);
+				}
+			}
+			std::cout << '\n';
+
+			std::cout << "Avg cash expenditure per game breakdown:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ":\n";
+				if constexpr (movement) {
+					std::cout << "    " << statistics.avg_tax_space_paid_per_game_approx(player) << " tax space\n";
+				}
+				if constexpr (cash_flow) {
+					std::cout << "    " << statistics.avg_jail_fee_per_game_approx(player) << " jail fee\n";
+					print_amount(statistics.avg_rent_paid_per_game(player), "rent",
+						stat_counters.rent_paid_moments[player]);
+				}
+				if constexpr (property) {
+					print_amount(statistics.avg_property_purchase_costs_per_game(player), "property purchase",
+						stat_counters.property_purchase_cost_moments[player]);
+				}
+				if constexpr (cards) {
+					print_amount(statistics.avg_cash_fee_card_amount_per_game(player), "cash fee card",
+						stat_counters.cash_fee_card_amount_moments[player]);
+					print_amount(statistics.avg_per_player_cash_award_card_amount_paid_per_game(player),
+						"per-player cash award card",
+						stat_counters.per_player_cash_award_card_payment_amount_moments[player]);
+				}
+			}
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg times sent to jail per turn:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": "
-				<< statistics.avg_times_sent_to_jail_per_turn(player) << '\n';
+		if constexpr (record_stat_group<stat_group_t::movement>) {
+			std::cout << "Avg times passed Go per turn:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": " << statistics.avg_go_passes_per_turn(player) << '\n';
+			}
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg jail duration:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": "
-				<< statistics.avg_jail_duration(player) << '\n';
+		if constexpr (record_stat_group<stat_group_t::movement>) {
+			std::cout << "Avg times sent to jail per turn:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": "
+					<< statistics.avg_times_sent_to_jail_per_turn(player) << '\n';
+			}
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg rent payments:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ":\n"
-				<< "    +" << statistics.avg_rent_received_per_turn(player) << "/turn  \t"
-				<< "    +" << statistics.avg_rent_received_per_rent(player) << "/rent\n"
-				<< "    -" << statistics.avg_rent_paid_per_turn(player) << "/turn  \t"
-				<< "    -" << statistics.avg_rent_paid_per_rent(player) << "/rent\n";
+		if constexpr (record_stat_group<stat_group_t::movement>) {
+			std::cout << "Avg jail duration:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": "
+					<< statistics.avg_jail_duration(player) << '\n';
+			}
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg cards drawn per turn:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": " << statistics.avg_cards_drawn_per_turn(player) << '\n';
+		if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+			std::cout << "Avg rent payments:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ":\n"
+					<< "    +" << statistics.avg_rent_received_per_turn(player) << "/turn  \t"
+					<< "    +" << statistics.avg_rent_received_per_rent(player) << "/rent\n"
+					<< "    -" << statistics.avg_rent_paid_per_turn(player) << "/turn  \t"
+					<< "    -" << statistics.avg_rent_paid_per_rent(player) << "/rent\n";
+			}
+			std::cout << '\n';
+
+			std::cout << "Rent payment quantiles:\n  ";
+			print_quantiles(stat_counters.rent_payment_histogram);
+			std::cout << "\n\n";
+
+			std::cout << "Rent paid per game quantiles (all players):\n  ";
+			print_quantiles(statistics.rent_per_game_quantiles());
+			std::cout << "\n\n";
 		}
-		std::cout << '\n';
 
-		std::cout << "Avg cash award card amount:\n";
-		std::cout << "  " << statistics.avg_cash_award_card_amount_per_cash_award_card() << "/cash_award_card\n";
-		std::cout << '\n';
+		if constexpr (record_stat_group<stat_group_t::cards>) {
+			std::cout << "Avg cards drawn per turn:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": " << statistics.avg_cards_drawn_per_turn(player) << '\n';
+			}
+			std::cout << '\n';
+		}
 
-		std::cout << "Avg cash fee card amount:\n";
-		std::cout << "  " << statistics.avg_cash_fee_card_amount_per_cash_fee_card() << "/cash_fee_card\n";
-		std::cout << '\n';
-	
-		std::cout << "Avg unowned property auctions won:\n";
-		for (auto const player : players) {
-			std::cout << "  Player " << player << ": "
-				<< statistics.avg_unowned_property_auctions_won_per_game(player) << "/game\n";
+		if constexpr (record_stat_group<stat_group_t::cards>) {
+			std::cout << "Avg cash award card amount:\n";
+			std::cout << "  " << statistics.avg_cash_award_card_amount_per_cash_award_card() << "/cash_award_card\n";
+			std::cout << '\n';
 		}
-		std::cout << '\n';
 
-		{
+		if constexpr (record_stat_group<stat_group_t::cards>) {
+			std::cout << "Avg cash fee card amount:\n";
+			std::cout << "  " << statistics.avg_cash_fee_card_amount_per_cash_fee_card() << "/cash_fee_card\n";
+			std::cout << '\n';
+		}
+
+		if constexpr (record_stat_group<stat_group_t::auctions>) {
+			std::cout << "Avg unowned property auctions won:\n";
+			for (auto const player : players) {
+				std::cout << "  Player " << player << ": "
+					<< statistics.avg_unowned_property_auctions_won_per_game(player) << "/game\n";
+			}
+			std::cout << '\n';
+
+			std::cout << "Unowned property auction price quantiles:\n  ";
+			print_quantiles(stat_counters.unowned_auction_price_histogram);
+			std::cout << "\n\n";
+		}
+
+		if constexpr (record_stat_group<stat_group_t::movement>) {
 			std::cout << "Board space relative frequencies:\n";
 			auto const rel_freqs = statistics.board_space_relative_frequencies();
 			auto const board_spaces = sorted_indices(rel_freqs);
@@ -139,7 +461,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::movement>) {
 			std::cout << "Board space frequency skew (absolute):\n";
 			for (auto const player : players) {
 				std::cout << "  Player " << player << ":\n";
@@ -154,7 +476,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::property>) {
 			std::cout << "Avg street purchase first round:\n";
 			auto const avg_rounds = statistics.avg_property_first_purchase_round<street_t>();
 			auto const street_indices = sorted_indices(avg_rounds);
@@ -164,7 +486,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::property>) {
 			std::cout << "Avg railway purchase first round:\n";
 			auto const avg_rounds = statistics.avg_property_first_purchase_round<railway_t>();
 			auto const railway_indices = sorted_indices(avg_rounds);
@@ -174,7 +496,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::property>) {
 			std::cout << "Avg utility purchase first round:\n";
 			auto const avg_rounds = statistics.avg_property_first_purchase_round<utility_t>();
 			auto const utility_indices = sorted_indices(avg_rounds);
@@ -184,7 +506,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::auctions>) {
 			std::cout << "Avg unowned street auction premium (proportional):\n";
 			auto const premiums = statistics.avg_unowned_property_auction_premium<street_t>();
 			auto const street_indices = sorted_indices(premiums, [](double s) { return std::abs(s); });
@@ -196,7 +518,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::auctions>) {
 			std::cout << "Avg unowned railway auction premium (proportional):\n";
 			auto const premiums = statistics.avg_unowned_property_auction_premium<railway_t>();
 			auto const railway_indices = sorted_indices(premiums, [](double s) { return std::abs(s); });
@@ -208,7 +530,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		{
+		if constexpr (record_stat_group<stat_group_t::auctions>) {
 			std::cout << "Avg unowned utility auction premium (proportional):\n";
 			auto const premiums = statistics.avg_unowned_property_auction_premium<utility_t>();
 			auto const utility_indices = sorted_indices(premiums, [](double s) { return std::abs(s); });
@@ -220,7 +542,7 @@ namespace monopoly {
 			std::cout << '\n';
 		}
 
-		// TODO: may want to show real time, not CPU time, in the case of multithreading
+		// Simulation time is summed over threads, so this is per CPU.
 		std::cout << "Simulation speed:\n"
 			<< "  " << statistics.avg_games_per_second() << " game/CPUsec\n"
 			<< "  " << statistics.avg_rounds_per_second() << " round/CPUsec\n"
@@ -228,32 +550,677 @@ namespace monopoly {
 			<< "  " << 1 / statistics.avg_games_per_second() << " CPUsec/game\n"
 			<< "  " << 1 / statistics.avg_rounds_per_second() << " CPUsec/round\n"
 			<< "  " << 1 / statistics.avg_turns_per_second() << " CPUsec/turn\n";
+
+		if (wall_seconds.has_value()) {
+			std::cout << "Wall clock throughput (" << *wall_seconds << " sec):\n"
+				<< "  " << div(stat_counters.games, *wall_seconds) << " game/sec\n"
+				<< "  " << div(stat_counters.rounds, *wall_seconds) << " round/sec\n"
+				<< "  " << div(sum(stat_counters.turns_played), *wall_seconds) << " turn/sec\n";
+		}
+
+		if (std::ranges::any_of(stat_counters.hardware_counter_turns, [](auto const turns) { return turns > 0; })) {
+			std::cout << "Hardware counters (per turn):\n";
+			for (unsigned i = 0; i < hardware_counter_count; ++i) {
+				auto const per_turn = statistics.hardware_counter_per_turn(static_cast<hardware_counter_t>(i));
+				if (per_turn.has_value()) {
+					std::cout << "  " << *per_turn << ' ' << hardware_counter_names[i] << '\n';
+				}
+			}
+			auto const instructions = statistics.hardware_counter_per_turn(hardware_counter_t::instructions);
+			auto const cycles = statistics.hardware_counter_per_turn(hardware_counter_t::cycles);
+			if (instructions.has_value() && cycles.has_value()) {
+				std::cout << "  " << div(*instructions, *cycles) << " IPC\n";
+			}
+		}
+
+		if constexpr (profile_phases) {
+			// No profile if the games weren't simulated by this process.
+			auto const profile = collect_phase_profile();
+			if (profile.calls[static_cast<unsigned>(profile_phase_t::turn)] > 0) {
+				std::cout << '\n';
+				print_phase_profile(profile);
+			}
+		}
+
+		if (rare_game_config.capacity > 0) {
+			std::cout << '\n';
+			print_rare_games(collect_rare_games());
+		}
+	}
+
+	void print_convergence(stat_counters_t const& stat_counters, convergence_criteria_t const& criteria,
+			bool const converged) {
+		auto const z = normal_two_sided_quantile(criteria.confidence);
+
+		std::cout << (converged ? "Converged" : "Did not converge") << " after " << stat_counters.games
+			<< " games\n";
+		std::cout << "Confidence interval half-widths (" << criteria.confidence * 100 << "%):\n";
+		for (auto const& target : criteria.targets) {
+			std::cout << "  " << convergence_metric_name(target.metric) << ": "
+				<< confidence_half_width(stat_counters, target.metric, z) << " (target " << target.half_width
+				<< ")\n";
+		}
+		std::cout << '\n';
+	}
+
+	// If expected_games is given, fails unless the files cover exactly those games.
+	int merge_counters_files(program_options_t const& options, std::span<std::filesystem::path const> const files,
+			std::optional<game_range_t> const expected_games = std::nullopt) {
+		auto const merged = merge_stat_counters_files(files);
+		if (!merged.has_value()) {
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "Merged " << files.size() << " files, seed " << merged->base_seed
+			<< ", covering games:\n";
+		for (auto const& range : merged->coverage) {
+			std::cout << "  " << range.first << '-' << range.end() << '\n';
+		}
+		if (!merged->is_contiguous()) {
+			std::cout << "Warning: games are missing between the ranges\n";
+		}
+		std::cout << '\n';
+
+		if (expected_games.has_value() && (merged->coverage.size() != 1
+				|| merged->coverage.front().first != expected_games->first
+				|| merged->coverage.front().count != expected_games->count)) {
+			std::cerr << "Error: the results don't cover exactly games " << expected_games->first << '-'
+				<< expected_games->end() << '\n';
+			return EXIT_FAILURE;
+		}
+
+		if (options.output_file.has_value()) {
+			if (!merged->is_contiguous()) {
+				std::cerr << "Error: can't write merged counters with missing games\n";
+				return EXIT_FAILURE;
+			}
+			if (!write_stat_counters_file(*options.output_file, merged->file_info(), merged->counters)) {
+				std::cerr << "Error: failed to write " << *options.output_file << '\n';
+				return EXIT_FAILURE;
+			}
+		}
+
+		print_statistics(merged->counters);
+		return export_statistics(options, merged->counters) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int run_seeded(program_options_t const& options, std::uint32_t max_rounds) {
+		auto const strategies_factory = [] {
+			return player_strategies_t{};
+		};
+
+		std::uint64_t base_seed = options.seed.value_or(0);
+		game_range_t games{0, options.game_count.value_or(default_game_count)};
+		if (options.shard.has_value()) {
+			games = split_game_range(games, options.shard->count, options.shard->index);
+		}
+
+		auto const start_time = std::chrono::steady_clock::now();
+		if (options.checkpoint_file.has_value()) {
+			checkpoint_t checkpoint;
+			if (options.resume) {
+				if (!read_checkpoint_file(*options.checkpoint_file, checkpoint)) {
+					std::cerr << "Error: failed to read checkpoint " << *options.checkpoint_file << '\n';
+					return EXIT_FAILURE;
+				}
+				std::uint64_t games_done = 0;
+				for (auto const& worker : checkpoint.workers) {
+					games_done += worker.next_game - worker.games.first;
+				}
+				std::cout << "Resuming from checkpoint with " << games_done << " of " << checkpoint.games.count
+					<< " games done\n\n";
+			}
+			else {
+				checkpoint = make_checkpoint(base_seed, max_rounds, games,
+					options.threads.value_or(default_thread_count()));
+			}
+
+			bool save_failed = false;
+			auto const save_checkpoint = [&options, &save_failed](checkpoint_t const& checkpoint) {
+				save_failed = !write_checkpoint_file(*options.checkpoint_file, checkpoint) || save_failed;
+			};
+			run_seeded_simulations_checkpointed(strategies_factory, checkpoint, options.games_per_chunk,
+				std::chrono::seconds{options.checkpoint_seconds}, save_checkpoint);
+			if (save_failed) {
+				std::cerr << "Warning: failed to write checkpoint " << *options.checkpoint_file << '\n';
+			}
+
+			base_seed = checkpoint.base_seed;
+			games = checkpoint.games;
+			max_rounds = checkpoint.max_rounds;
+		}
+		else if (options.processes.has_value()) {
+			if (!process_pool_supported) {
+				std::cerr << "Error: --processes is not supported on this platform\n";
+				return EXIT_FAILURE;
+			}
+			auto const game_max_rounds = max_rounds > 0 ? std::optional{max_rounds} : std::nullopt;
+			auto const result = run_seeded_simulations_process_pool(base_seed, games, game_max_rounds,
+				*options.processes, options.games_per_chunk, options.max_failures);
+
+			for (auto const& failed : result.failed_games) {
+				std::cerr << "Game " << failed.game << " (seed " << failed.seed << ") crashed: ";
+				if (failed.signal != 0) {
+					std::cerr << "signal " << failed.signal << '\n';
+				}
+				else {
+					std::cerr << "exit code " << failed.exit_code << '\n';
+				}
+			}
+			if (!result.completed) {
+				std::cerr << "Error: run abandoned (" << result.failed_games.size() << " crashed games)\n";
+				return EXIT_FAILURE;
+			}
+			if (!result.failed_games.empty()) {
+				std::cout << "Warning: " << result.failed_games.size()
+					<< " crashed games are excluded from the statistics\n\n";
+				if (options.output_file.has_value()) {
+					// The file would claim games which aren't included, which merging relies on.
+					std::cerr << "Error: not writing " << *options.output_file << " since games are missing\n";
+					return EXIT_FAILURE;
+				}
+			}
+		}
+		else if (options.game_output_file.has_value()) {
+			auto const threads = options.threads.value_or(default_thread_count());
+			game_output_writer_t game_output{*options.game_output_file, threads, options.game_output_policy};
+			run_seeded_simulations_multithreaded(strategies_factory, base_seed, games, max_rounds, threads,
+				options.interleave, &game_output);
+			if (!game_output.finish()) {
+				std::cerr << "Error: failed to write " << *options.game_output_file << '\n';
+				return EXIT_FAILURE;
+			}
+			if (auto const dropped = game_output.dropped_count(); dropped > 0) {
+				std::cout << "Warning: " << dropped << " game records were dropped since the writer fell behind\n\n";
+			}
+		}
+		else {
+			run_seeded_simulations_multithreaded(strategies_factory, base_seed, games, max_rounds, options.threads,
+				options.interleave);
+		}
+
+		if (options.output_file.has_value()) {
+			stat_counters_file_info_t const info{base_seed, games.first, games.count, max_rounds};
+			if (!write_stat_counters_file(*options.output_file, info, stat_counters)) {
+				std::cerr << "Error: failed to write " << *options.output_file << '\n';
+				return EXIT_FAILURE;
+			}
+		}
+
+		if (options.shard.has_value()) {
+			std::cout << "Shard " << options.shard->index << '/' << options.shard->count << ": games "
+				<< games.first << '-' << games.end() << " written to " << *options.output_file << '\n';
+		}
+		else if (record_stats) {
+			// A resumed run's counters include games from before it was interrupted.
+			std::optional<double> wall_seconds;
+			if (!options.resume) {
+				wall_seconds = std::chrono::duration<double>{std::chrono::steady_clock::now() - start_time}.count();
+			}
+			print_statistics(stat_counters, wall_seconds);
+		}
+		return export_statistics(options, stat_counters) ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int benchmark_interleave(program_options_t const& options, std::uint32_t const max_rounds) {
+		auto const strategies_factory = [] {
+			return player_strategies_t{};
+		};
+		auto const threads = options.threads.value_or(default_thread_count());
+		game_range_t const games{0, options.game_count.value_or(default_game_count / 10)};
+
+		std::cout << "Interleaved games per thread, " << games.count << " games, " << threads << " threads:\n";
+		for (unsigned const interleave : {1u, 2u, 4u, 8u, 16u, 32u, 64u}) {
+			auto const start_time = std::chrono::steady_clock::now();
+			run_seeded_simulations_multithreaded(strategies_factory, options.seed.value_or(0), games, max_rounds,
+				threads, interleave);
+			std::chrono::duration<double> const elapsed = std::chrono::steady_clock::now() - start_time;
+
+			auto const turns = sum(stat_counters.turns_played);
+			std::cout << "  K=" << interleave << ": " << turns / elapsed.count() << " turn/sec (" << turns
+				<< " turns, " << elapsed.count() << " sec)\n";
+		}
+		return EXIT_SUCCESS;
+	}
+
+	int benchmark_scaling(program_options_t const& options, std::uint32_t const max_rounds) {
+		game_range_t const games{0, options.game_count.value_or(default_game_count / 10)};
+		auto const thread_counts = scaling_thread_counts(options.threads.value_or(default_thread_count()));
+		auto const measurements = run_scaling_benchmark(options.seed.value_or(0), games, max_rounds, thread_counts);
+
+		std::cout << "Thread scaling, " << games.count << " games:\n";
+		std::cout << std::left << std::setw(10) << "  threads" << std::setw(12) << "wall sec" << std::setw(12)
+			<< "CPU sec" << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << std::setw(11)
+			<< "imbalance" << "turn/sec\n";
+		auto const baseline_seconds = measurements.front().wall_seconds;
+		for (auto const& measurement : measurements) {
+			auto const speedup = baseline_seconds / measurement.wall_seconds;
+			std::cout << "  " << std::setw(8) << measurement.threads << std::setw(12) << measurement.wall_seconds
+				<< std::setw(12) << measurement.cpu_seconds << std::setw(10) << speedup << std::setw(12)
+				<< speedup / measurement.threads << std::setw(11) << measurement.imbalance()
+				<< div(measurement.turns, measurement.wall_seconds) << '\n';
+		}
+		std::cout << std::right;
+		return EXIT_SUCCESS;
+	}
+
+	int benchmark_macro(program_options_t const& options) {
+		auto const threads = options.threads.value_or(1);
+		auto const game_count = options.game_count.value_or(default_game_count / 10);
+		auto const machine = describe_machine();
+		auto const results = run_macro_benchmark(options.seed.value_or(0), game_count, threads, 3);
+
+		std::cout << "Macro benchmark, " << threads << " threads, " << machine.cpu << ":\n";
+		std::cout << std::left << std::setw(34) << "  workload" << std::setw(12) << "seconds" << std::setw(12)
+			<< "game/sec" << std::setw(14) << "turn/sec" << "ns/turn\n";
+		for (auto const& result : results) {
+			std::cout << "  " << std::setw(32) << result.name << std::setw(12) << result.seconds << std::setw(12)
+				<< result.games_per_second() << std::setw(14) << result.turns_per_second() << result.ns_per_turn()
+				<< '\n';
+		}
+		std::cout << std::right;
+
+		if (options.benchmark_json_file.has_value()) {
+			std::ofstream file{*options.benchmark_json_file, std::ios::trunc};
+			write_macro_benchmark_json(file, machine, threads, results);
+			if (!file.flush()) {
+				std::cerr << "Error: failed to write " << *options.benchmark_json_file << '\n';
+				return EXIT_FAILURE;
+			}
+		}
+
+		if (!options.benchmark_baseline_file.has_value()) {
+			return EXIT_SUCCESS;
+		}
+		auto const baseline = read_macro_benchmark_baseline(*options.benchmark_baseline_file);
+		if (!baseline.has_value()) {
+			std::cerr << "Error: failed to read " << *options.benchmark_baseline_file << '\n';
+			return EXIT_FAILURE;
+		}
+		if (baseline->cpu != machine.cpu) {
+			std::cout << "Warning: baseline was measured on a different CPU (" << baseline->cpu << ")\n";
+		}
+		// Throughput scales with the thread count, so only runs with the same count are comparable.
+		if (baseline->threads != threads) {
+			std::cerr << "Error: baseline was measured with " << baseline->threads << " threads, not " << threads
+				<< '\n';
+			return EXIT_FAILURE;
+		}
+
+		auto const find_baseline = [&baseline](macro_benchmark_result_t const& result) {
+			return std::ranges::find(baseline->workloads, result.name, &macro_baseline_t::workload_t::name);
+		};
+		if (std::ranges::none_of(results, [&](auto const& result) {
+				return find_baseline(result) != baseline->workloads.end(); })) {
+			std::cerr << "Error: no workloads of this build (" << macro_benchmark_variant() << ") in the baseline\n";
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "Compared with baseline (tolerance " << options.benchmark_tolerance * 100 << "%):\n";
+		bool regressed = false;
+		for (auto const& result : results) {
+			auto const base = find_baseline(result);
+			if (base == baseline->workloads.end()) {
+				continue;
+			}
+			auto const ratio = result.turns_per_second() / base->turns_per_second;
+			auto const failed = ratio < 1 - options.benchmark_tolerance;
+			regressed = regressed || failed;
+			std::cout << "  " << std::left << std::setw(32) << result.name << std::right << std::showpos
+				<< (ratio - 1) * 100 << std::noshowpos << "% turn/sec" << (failed ? "  REGRESSION" : "") << '\n';
+		}
+		return regressed ? EXIT_FAILURE : EXIT_SUCCESS;
+	}
+
+	int check_golden_hashes(program_options_t const& options) {
+		std::vector<golden_result_t> results;
+		for (auto const& config : golden_configs) {
+			results.push_back(run_golden_config(config));
+		}
+
+		if (options.golden_write_file.has_value()) {
+			std::ofstream file{*options.golden_write_file, std::ios::trunc};
+			write_golden_results(file, results);
+			if (!file.flush()) {
+				std::cerr << "Error: failed to write " << *options.golden_write_file << '\n';
+				return EXIT_FAILURE;
+			}
+			std::cout << "Wrote golden hashes of " << results.size() << " configurations to "
+				<< *options.golden_write_file << '\n';
+		}
+
+		if (!options.golden_check_file.has_value()) {
+			return EXIT_SUCCESS;
+		}
+		auto const expected = read_golden_results(*options.golden_check_file);
+		if (!expected.has_value()) {
+			std::cerr << "Error: failed to read " << *options.golden_check_file << '\n';
+			return EXIT_FAILURE;
+		}
+
+		std::cout << "Compared with golden hashes:\n";
+		std::size_t compared = 0;
+		bool all_match = true;
+		std::optional<std::string> first_differing_game;
+		for (auto const& result : results) {
+			auto const expected_result = std::ranges::find(*expected, result.name, &golden_result_t::name);
+			if (expected_result == expected->end()) {
+				continue;
+			}
+			++compared;
+			auto const comparison = compare_golden_results(*expected_result, result);
+			std::cout << "  " << std::left << std::setw(30) << result.name << std::right;
+			if (comparison.matches()) {
+				std::cout << "match\n";
+				continue;
+			}
+			std::cout << "DIFFERENT\n";
+			all_match = false;
+			if (comparison.game_count_differs) {
+				std::cout << "    " << expected_result->games.size() << " games expected, " << result.games.size()
+					<< " played\n";
+			}
+			if (comparison.first_differing_game.has_value()) {
+				std::cout << "    " << comparison.differing_games << " games differ, first is game "
+					<< *comparison.first_differing_game << '\n';
+				if (!first_differing_game.has_value()) {
+					auto const config = result.name.substr(result.name.find('/') + 1);
+					first_differing_game = config + ':' + std::to_string(*comparison.first_differing_game);
+				}
+			}
+			if (!comparison.differing_counters.empty()) {
+				std::cout << "    counters differ:";
+				for (auto const& counter : comparison.differing_counters) {
+					std::cout << ' ' << counter;
+				}
+				std::cout << '\n';
+			}
+		}
+		if (compared == 0) {
+			std::cerr << "Error: no configurations of this build (" << golden_variant() << ") in the golden hashes\n";
+			return EXIT_FAILURE;
+		}
+		if (first_differing_game.has_value()) {
+			std::cout << "To find the first differing turn, run the build which wrote the golden hashes with\n"
+				"  --golden-trace FILE --golden-game " << *first_differing_game << "\n"
+				"and this build with\n"
+				"  --golden-trace-check FILE\n";
+		}
+		return all_match ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+
+	int trace_golden_game(program_options_t const& options) {
+		if (options.golden_trace_file.has_value()) {
+			auto const config = find_golden_config(options.golden_game->config);
+			if (config == nullptr || options.golden_game->game >= config->game_count) {
+				std::cerr << "Error: no golden game " << options.golden_game->config << ':'
+					<< options.golden_game->game << '\n';
+				return EXIT_FAILURE;
+			}
+			auto const trace = trace_golden_game(*config, options.golden_game->game);
+			std::ofstream file{*options.golden_trace_file, std::ios::trunc};
+			write_golden_trace(file, trace);
+			if (!file.flush()) {
+				std::cerr << "Error: failed to write " << *options.golden_trace_file << '\n';
+				return EXIT_FAILURE;
+			}
+			std::cout << "Wrote " << trace.turns.size() << " turns to " << *options.golden_trace_file << '\n';
+			return EXIT_SUCCESS;
+		}
+
+		auto const expected = read_golden_trace(*options.golden_trace_check_file);
+		if (!expected.has_value()) {
+			std::cerr << "Error: failed to read " << *options.golden_trace_check_file << '\n';
+			return EXIT_FAILURE;
+		}
+		auto const config = find_golden_config(expected->config);
+		if (config == nullptr || expected->variant != golden_variant()) {
+			std::cerr << "Error: the trace is of a configuration (" << expected->variant << '/' << expected->config
+				<< ") which this build doesn't play\n";
+			return EXIT_FAILURE;
+		}
+		auto const actual = trace_golden_game(*config, expected->game);
+		auto const turn = first_differing_turn(*expected, actual);
+		std::cout << "Game " << expected->variant << '/' << expected->config << ':' << expected->game;
+		if (!turn.has_value()) {
+			std::cout << " matches the trace (" << actual.turns.size() << " turns)\n";
+			return EXIT_SUCCESS;
+		}
+		std::cout << " first differs at turn " << *turn;
+		if (*turn < actual.turns.size()) {
+			std::cout << " (round " << actual.turns[*turn].round << ')';
+		}
+		std::cout << "; " << expected->turns.size() << " turns expected, " << actual.turns.size() << " played\n";
+		return EXIT_FAILURE;
+	}
+
+	int replay_game(program_options_t const& options, std::uint32_t const max_rounds) {
+		auto const seed = *options.replay_game_seed;
+		game_state_t game_state;
+		player_strategies_t strategies;
+		random_t random{seed};
+		simulate_game(game_state, strategies, random, max_rounds, invariant_check_t{std::nullopt, seed},
+			begin_sampled_event_trace(0, seed));
+
+		std::cout << "Game with seed " << seed << ":\n";
+		print_rare_game_header();
+		print_rare_game(summarise_rare_game(game_state, seed));
+		return EXIT_SUCCESS;
+	}
+
+	int run_work_queue(program_options_t const& options, std::uint32_t const max_rounds) {
+		work_queue_t queue{*options.queue_dir};
+
+		switch (options.queue_action) {
+		case queue_action_t::init: {
+			game_range_t const games{0, options.game_count.value_or(default_game_count)};
+			work_queue_config_t const config{*options.seed, max_rounds, games};
+			if (!queue.initialise(config, options.range_games)) {
+				std::cerr << "Error: failed to create work queue in " << *options.queue_dir << '\n';
+				return EXIT_FAILURE;
+			}
+			std::cout << "Created work queue with " << queue.status().pending << " ranges\n";
+			return EXIT_SUCCESS;
+		}
+
+		case queue_action_t::work: {
+			auto const config = queue.read_config();
+			if (!config.has_value()) {
+				std::cerr << "Error: failed to read work queue in " << *options.queue_dir << '\n';
+				return EXIT_FAILURE;
+			}
+			auto const stale_age = std::chrono::seconds{options.stale_seconds};
+			auto const game_max_rounds =
+				config->max_rounds > 0 ? std::optional{config->max_rounds} : std::nullopt;
+			auto const strategies_factory = [] {
+				return player_strategies_t{};
+			};
+
+			std::size_t ranges_completed = 0;
+			while (true) {
+				auto const range = queue.claim();
+				if (!range.has_value()) {
+					// Pick up work abandoned by dead workers before giving up.
+					if (queue.requeue_stale(stale_age) > 0) {
+						continue;
+					}
+					break;
+				}
+
+				{
+					work_queue_heartbeat_t const heartbeat{queue, *range, stale_age / 4};
+					run_seeded_simulations_multithreaded(strategies_factory, config->base_seed, *range,
+						game_max_rounds, options.threads);
+				}
+				if (!queue.complete(*range, *config, stat_counters)) {
+					std::cerr << "Error: failed to write results for games " << range->first << '-' << range->end()
+						<< '\n';
+					return EXIT_FAILURE;
+				}
+				++ranges_completed;
+			}
+
+			std::cout << "No work left, completed " << ranges_completed << " ranges\n";
+			return EXIT_SUCCESS;
+		}
+
+		case queue_action_t::merge: {
+			auto const config = queue.read_config();
+			if (!config.has_value()) {
+				std::cerr << "Error: failed to read work queue in " << *options.queue_dir << '\n';
+				return EXIT_FAILURE;
+			}
+			auto const status = queue.status();
+			std::cout << "Work queue: " << status.completed << " completed, " << status.claimed << " in progress, "
+				<< status.pending << " pending\n";
+			if (status.claimed > 0 || status.pending > 0) {
+				std::cerr << "Error: the work queue isn't finished\n";
+				return EXIT_FAILURE;
+			}
+			return merge_counters_files(options, queue.completed_result_files(), config->games);
+		}
+		}
+		return EXIT_FAILURE;
+	}
+
+	int print_event_trace(std::filesystem::path const& path) {
+		std::ifstream stream{path, std::ios::binary};
+		if (!stream) {
+			std::cerr << "Error: failed to read " << path << '\n';
+			return EXIT_FAILURE;
+		}
+		if (!dump_event_trace(stream, std::cout)) {
+			std::cerr << "Error: " << path << " isn't a complete event trace\n";
+			return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+
+	// Runs the mode selected by the options.
+	int run(program_options_t const& options) {
+		constexpr auto max_rounds = 100;
+
+		auto const strategies_factory = [] {
+			return player_strategies_t{};
+		};
+
+		auto const random_factory = [] {
+			return random_t{std::random_device{}()};
+		};
+
+		if (options.event_trace_dump_file.has_value()) {
+			return print_event_trace(*options.event_trace_dump_file);
+		}
+		else if (options.merge) {
+			return merge_counters_files(options, options.input_files);
+		}
+		else if (options.queue_dir.has_value()) {
+			return run_work_queue(options, max_rounds);
+		}
+		else if (options.benchmark_scaling) {
+			return benchmark_scaling(options, max_rounds);
+		}
+		else if (options.replay_game_seed.has_value()) {
+			return replay_game(options, max_rounds);
+		}
+		else if (options.golden_write_file.has_value() || options.golden_check_file.has_value()) {
+			return check_golden_hashes(options);
+		}
+		else if (options.golden_trace_file.has_value() || options.golden_trace_check_file.has_value()) {
+			return trace_golden_game(options);
+		}
+		else if (options.benchmark_macro) {
+			return benchmark_macro(options);
+		}
+		else if (options.benchmark_interleave) {
+			return benchmark_interleave(options, max_rounds);
+		}
+		else if (options.seed.has_value() || options.resume) {
+			return run_seeded(options, max_rounds);
+		}
+		else if (options.convergence.targets.empty()) {
+			auto const game_count = options.game_count.value_or(default_game_count);
+			auto const start_time = std::chrono::steady_clock::now();
+			run_simulations_multithreaded(strategies_factory, random_factory, game_count, max_rounds, options.threads);
+			std::chrono::duration<double> const wall_time = std::chrono::steady_clock::now() - start_time;
+
+			if (record_stats) {
+				print_statistics(stat_counters, wall_time.count());
+			}
+			return export_statistics(options, stat_counters) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
+		else {
+			simulation_budget_t const budget{options.game_count, options.max_seconds};
+			auto const start_time = std::chrono::steady_clock::now();
+			auto const converged = run_simulations_until_converged(strategies_factory, random_factory,
+				options.convergence, budget, options.games_per_chunk, max_rounds, options.threads);
+			std::chrono::duration<double> const wall_time = std::chrono::steady_clock::now() - start_time;
+
+			if (record_stats) {
+				print_convergence(stat_counters, options.convergence, converged);
+				print_statistics(stat_counters, wall_time.count());
+			}
+			return export_statistics(options, stat_counters) ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
 	}
 
 }
 
 
-int main() {
+int main(int argc, char* argv[]) {
 	using namespace monopoly;
 
-#if defined(NDEBUG) || defined(RELEASE)
-	constexpr std::size_t game_count = 1'000'000;
-#else
-	constexpr std::size_t game_count = 1000;
-#endif
-	constexpr auto max_rounds = 100;
+	auto const options = parse_command_line(argc, argv);
+	if (!options.has_value()) {
+		return EXIT_FAILURE;
+	}
+	if (options->help) {
+		print_usage(std::cout);
+		return EXIT_SUCCESS;
+	}
+
+	if (options->hardware_counters) {
+		hardware_counters_enabled = true;
+		auto const available = read_thread_hardware_counters();
+		if (std::ranges::none_of(available, [](auto const& value) { return value.has_value(); })) {
+			std::cerr << "Warning: hardware counters are not available (unsupported platform, no access to the PMU, "
+				"or restricted by perf_event_paranoid)\n";
+		}
+	}
 
-	auto const strategies_factory = [] {
-		return player_strategies_t{};
-	};
+	if (options->check_invariants.has_value()) {
+		invariant_check_interval = *options->check_invariants;
+	}
+
+	if (options->rare_games.has_value()) {
+		rare_game_config.capacity = *options->rare_games;
+		if (!options->rare_game_criteria.empty()) {
+			rare_game_config.criteria.fill(false);
+			for (auto const criterion : options->rare_game_criteria) {
+				rare_game_config.criteria[static_cast<unsigned>(criterion)] = true;
+			}
+		}
+	}
 
-	auto const random_factory = [] {
-		return random_t{std::random_device{}()};
-	};
+	std::optional<event_trace_writer_t> event_trace;
+	if (options->event_trace_file.has_value()) {
+		event_trace.emplace(*options->event_trace_file);
+		event_trace_writer = &*event_trace;
+		event_trace_interval = options->event_trace_interval.value_or(1);
+	}
 
-	run_simulations_multithreaded(strategies_factory, random_factory, game_count, max_rounds);
+	auto result = run(*options);
 
-	if (record_stats) {
-		print_statistics(stat_counters);
+	if (event_trace.has_value()) {
+		if (!event_trace->finish()) {
+			std::cerr << "Error: failed to write " << *options->event_trace_file << '\n';
+			result = EXIT_FAILURE;
+		}
+		else {
+			std::cout << "Traced " << event_trace->game_count() << " games (" << event_trace->byte_count()
+				<< " bytes) to " << *options->event_trace_file << '\n';
+		}
+		event_trace_writer = nullptr;
 	}
+	return result;
 }
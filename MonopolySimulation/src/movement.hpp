@@ -17,8 +17,8 @@ namespace monopoly::detail {
 
 	inline void on_passed_go(game_state_t& game_state, unsigned const player) {
 		pay_go_salary(game_state, player);
-		if constexpr (record_stats) {
-			stat_counters.go_passes[player]++;
+		if constexpr (record_stat_group<stat_group_t::movement>) {
+			game_state.stats.go_passes[player]++;
 		}
 	}
 
@@ -78,8 +78,8 @@ namespace monopoly {
 		// No rule about this but presumably it resets when going to jail.
 		game_state.players[player].consecutive_doubles = 0;
 
-		if constexpr (record_stats) {
-			stat_counters.sent_to_jail_count[player]++;
+		if constexpr (record_stat_group<stat_group_t::movement>) {
+			game_state.stats.sent_to_jail_count[player]++;
 		}
 	}
 
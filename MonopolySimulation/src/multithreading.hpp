@@ -9,6 +9,37 @@
 
 namespace monopoly {
 
+	// Number of threads to use when not otherwise specified.
+	[[nodiscard]]
+	inline unsigned default_thread_count() noexcept {
+		auto const hw_threads = std::thread::hardware_concurrency();
+		if (hw_threads > 0) {
+			return hw_threads;
+		}
+		else {
+			return 4;
+		}
+	}
+
+
+	// Runs func(thread_index) on thread_count threads and waits for them to finish.
+	// Thread index 0 is run on the calling thread.
+	inline void run_multithreaded(auto func, unsigned const thread_count) {
+		assert(thread_count >= 1);
+		std::vector<std::thread> threads;
+		threads.reserve(thread_count - 1);
+
+		for (unsigned i = 1; i < thread_count; ++i) {
+			threads.emplace_back(func, i);
+		}
+
+		func(0u);
+
+		for (auto& thread : threads) {
+			thread.join();
+		}
+	}
+
 	// Runs func on thread_count threads and reduces the results.
 	template<typename Result, typename Reducer = std::plus<Result>>
 	Result map_multithreaded(auto func, unsigned const thread_count, Reducer reducer = {}) {
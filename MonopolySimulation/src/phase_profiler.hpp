@@ -0,0 +1,173 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string_view>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MONOPOLY_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MONOPOLY_HAS_RDTSC 1
+#endif
+
+
+// Per-phase cycle profiler for the turn loop, enabled at build time with -DMONOPOLY_PROFILE_PHASES=1.
+// Timers are placed at phase boundaries and accumulate into thread local slots, which are merged when threads exit.
+// Phases nest (e.g. rent within board space within card), so both inclusive and self (excluding nested phases) time
+// is recorded. When disabled the timers are empty and compile to nothing.
+// Only threads of this process are covered, not process pool workers.
+#ifndef MONOPOLY_PROFILE_PHASES
+#define MONOPOLY_PROFILE_PHASES 0
+#endif
+
+namespace monopoly {
+
+	inline constexpr bool profile_phases = MONOPOLY_PROFILE_PHASES;
+
+	enum class profile_phase_t : unsigned {
+		turn,
+		jail,
+		dice,
+		movement,
+		board_space,
+		card,
+		rent,
+		auction,
+		forced_sale,
+		stats
+	};
+
+	inline constexpr unsigned profile_phase_count = 10;
+
+	inline constexpr std::array<std::string_view, profile_phase_count> profile_phase_names{
+		"turn",
+		"jail",
+		"dice",
+		"movement",
+		"board space",
+		"card",
+		"rent",
+		"auction",
+		"forced sale",
+		"stats"
+	};
+
+	// Timestamp counter if available (units of reference cycles), otherwise nanoseconds.
+	[[nodiscard]]
+	inline std::uint64_t read_timestamp() noexcept {
+#ifdef MONOPOLY_HAS_RDTSC
+		return __rdtsc();
+#else
+		return static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+	}
+
+	struct phase_profile_t {
+		// Time within the phase, including nested phases. Recursion of a phase is counted once.
+		std::array<std::uint64_t, profile_phase_count> cycles{};
+		// Time within the phase, excluding nested phases.
+		std::array<std::uint64_t, profile_phase_count> self_cycles{};
+		std::array<std::uint64_t, profile_phase_count> calls{};
+
+		phase_profile_t& operator+=(phase_profile_t const& other) noexcept {
+			for (unsigned i = 0; i < profile_phase_count; ++i) {
+				cycles[i] += other.cycles[i];
+				self_cycles[i] += other.self_cycles[i];
+				calls[i] += other.calls[i];
+			}
+			return *this;
+		}
+	};
+
+	namespace phase_profiler_detail {
+
+		inline std::mutex exited_threads_mutex;
+		inline phase_profile_t exited_threads_profile;
+
+		struct thread_profile_t {
+			phase_profile_t profile;
+			// Number of active timers of each phase, to detect recursion.
+			std::array<unsigned, profile_phase_count> depth{};
+
+			~thread_profile_t() {
+				std::lock_guard const lock{exited_threads_mutex};
+				exited_threads_profile += profile;
+			}
+		};
+
+		thread_local inline thread_profile_t thread_profile;
+
+	}
+
+	// Profile of all exited threads plus the calling thread.
+	[[nodiscard]]
+	inline phase_profile_t collect_phase_profile() {
+		std::lock_guard const lock{phase_profiler_detail::exited_threads_mutex};
+		auto profile = phase_profiler_detail::exited_threads_profile;
+		profile += phase_profiler_detail::thread_profile.profile;
+		return profile;
+	}
+
+
+	template<bool Enabled>
+	class basic_phase_timer;
+
+	template<>
+	class basic_phase_timer<false> {
+	public:
+		constexpr explicit basic_phase_timer(profile_phase_t) noexcept {}
+	};
+
+	template<>
+	class basic_phase_timer<true> {
+	public:
+		explicit basic_phase_timer(profile_phase_t const phase) noexcept :
+			_phase{static_cast<unsigned>(phase)},
+			_parent{active_timer} {
+			active_timer = this;
+			phase_profiler_detail::thread_profile.depth[_phase]++;
+			_start = read_timestamp();
+		}
+
+		basic_phase_timer(basic_phase_timer const&) = delete;
+		basic_phase_timer& operator=(basic_phase_timer const&) = delete;
+
+		~basic_phase_timer() {
+			auto const elapsed = read_timestamp() - _start;
+			auto& thread_profile = phase_profiler_detail::thread_profile;
+			auto const depth = --thread_profile.depth[_phase];
+			if (depth == 0) {
+				thread_profile.profile.cycles[_phase] += elapsed;
+			}
+			thread_profile.profile.self_cycles[_phase] += elapsed - _nested_cycles;
+			thread_profile.profile.calls[_phase]++;
+			if (_parent != nullptr) {
+				_parent->_nested_cycles += elapsed;
+			}
+			active_timer = _parent;
+		}
+
+	private:
+		thread_local inline static basic_phase_timer* active_timer = nullptr;
+
+		unsigned _phase;
+		basic_phase_timer* _parent;
+		std::uint64_t _start = 0;
+		std::uint64_t _nested_cycles = 0;
+	};
+
+	// Times its scope as the given phase, if profile_phases is enabled.
+	using scoped_phase_timer = basic_phase_timer<profile_phases>;
+
+	// Times func() as the given phase, for phases which are a single expression.
+	template<profile_phase_t Phase>
+	decltype(auto) profile_phase(auto&& func) {
+		scoped_phase_timer const timer{Phase};
+		return func();
+	}
+
+}
@@ -3,6 +3,7 @@
 #include <cassert>
 #include <concepts>
 #include <tuple>
+#include <type_traits>
 #include <utility>
 
 #include "common_types.hpp"
@@ -14,8 +15,16 @@
 #include "strategy_types.hpp"
 
 
+// Every player can be made to always roll for doubles in jail at build time (e.g. -DMONOPOLY_ALWAYS_ROLL_JAIL=1), to
+// benchmark or compare against the default strategies.
+#ifndef MONOPOLY_ALWAYS_ROLL_JAIL
+#define MONOPOLY_ALWAYS_ROLL_JAIL 0
+#endif
+
 namespace monopoly {
 
+	inline constexpr bool always_roll_jail = MONOPOLY_ALWAYS_ROLL_JAIL;
+
 	// Always use Get Out Of Jail Free if the player has one, otherwise roll doubles.
 	struct always_use_card_jail_strategy_t {
 		[[nodiscard]]
@@ -247,25 +256,29 @@ namespace monopoly {
 	};
 
 
+	// Jail strategy of every player.
+	using default_jail_strategy_t =
+		std::conditional_t<always_roll_jail, always_roll_jail_strategy_t, get_out_fast_jail_strategy_t>;
+
 	struct player_strategies_t {
 		std::tuple<
 			flexible_player_strategy_t<
-				get_out_fast_jail_strategy_t,
+				default_jail_strategy_t,
 				always_buy_unowned_property_buy_strategy_t,
 				random_unowned_property_bid_strategy_t,
 				basic_forced_sale_strategy_t>,
 			flexible_player_strategy_t<
-				get_out_fast_jail_strategy_t,
+				default_jail_strategy_t,
 				always_buy_unowned_property_buy_strategy_t,
 				random_unowned_property_bid_strategy_t,
 				basic_forced_sale_strategy_t>,
 			flexible_player_strategy_t<
-				get_out_fast_jail_strategy_t,
+				default_jail_strategy_t,
 				always_buy_unowned_property_buy_strategy_t,
 				random_unowned_property_bid_strategy_t,
 				basic_forced_sale_strategy_t>,
 			flexible_player_strategy_t<
-				get_out_fast_jail_strategy_t,
+				default_jail_strategy_t,
 				always_buy_unowned_property_buy_strategy_t,
 				random_unowned_property_bid_strategy_t,
 				basic_forced_sale_strategy_t>
@@ -4,6 +4,7 @@
 #include <utility>
 
 #include "common_constants.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
 #include "statistics_counters.hpp"
 
@@ -21,18 +22,21 @@ namespace monopoly {
 		assert(std::cmp_less(position, board_space_count));
 
 		player_state.position = position;
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->move(game_state, player, position);
+		}
 
 #ifndef NDEBUG
 		game_state.turn.position_changed = true;
 #endif
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::movement>) {
 			if (position >= 0) {
-				stat_counters.board_space_counts[player][position]++;
+				game_state.stats.board_space_counts[player][position]++;
 			}
 			else {
 				// Jail.
-				stat_counters.board_space_counts[player].back()++;
+				game_state.stats.board_space_counts[player].back()++;
 			}
 		}
 	}
@@ -0,0 +1,256 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <cerrno>
+#include <csignal>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#define MONOPOLY_PROCESS_POOL_SUPPORTED 1
+#endif
+
+#include "game_range.hpp"
+#include "game_state.hpp"
+#include "invariant_check.hpp"
+#include "player_strategy.hpp"
+#include "random.hpp"
+#include "simulation.hpp"
+#include "statistics_counters.hpp"
+
+
+// Runs seeded games in forked worker processes instead of threads, so that a crash (e.g. a failed assert) only loses
+// the game being played rather than the whole run.
+// Each worker publishes its counters to a slot in a shared memory arena after every chunk of games. If a worker dies,
+// the game it was playing is recorded as failed and a new worker continues from the last published chunk, skipping
+// the failed game.
+namespace monopoly {
+
+#ifdef MONOPOLY_PROCESS_POOL_SUPPORTED
+	inline constexpr bool process_pool_supported = true;
+#else
+	inline constexpr bool process_pool_supported = false;
+#endif
+
+
+	struct failed_game_t {
+		std::uint64_t game;
+		std::uint64_t seed;
+		// Signal which killed the worker, or 0 if it exited with an error code.
+		int signal;
+		int exit_code;
+	};
+
+	struct process_pool_result_t {
+		// Games which crashed their worker. These are excluded from the statistics.
+		std::vector<failed_game_t> failed_games;
+		// False if the run was abandoned, e.g. due to too many failures.
+		bool completed = false;
+	};
+
+
+	// Lives in shared memory, written by one worker process and read by the parent.
+	struct process_worker_slot_t {
+		struct snapshot_t {
+			// Games in the worker's range before this have been played (or skipped).
+			std::uint64_t next_game;
+			stat_counters_t counters;
+		};
+
+		static constexpr std::uint64_t no_game = std::numeric_limits<std::uint64_t>::max();
+
+		// Double buffered so a worker dying part way through publishing can't corrupt the last good snapshot.
+		std::array<snapshot_t, 2> snapshots;
+		std::atomic<std::uint32_t> valid_snapshot{0};
+		// Game being played right now (no_game between games), for identifying the game which caused a crash.
+		std::atomic<std::uint64_t> current_game{no_game};
+
+		static_assert(std::is_trivially_copyable_v<stat_counters_t>,
+			"Counters must be safe to share between processes");
+		static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "Atomics must be usable across processes");
+	};
+
+
+#ifdef MONOPOLY_PROCESS_POOL_SUPPORTED
+
+	namespace detail {
+
+		[[noreturn]]
+		inline void process_pool_worker(process_worker_slot_t& slot, std::uint64_t const base_seed,
+				game_range_t const games, std::optional<unsigned> const max_rounds,
+				std::uint64_t const games_per_chunk, std::vector<std::uint64_t> const& skip_games) {
+			auto const& committed = slot.snapshots[slot.valid_snapshot.load(std::memory_order_acquire)];
+			stat_counters = committed.counters;
+			auto next_game = committed.next_game;
+			// Counters inherited from the parent would count the parent's thread.
+			reset_thread_hardware_counters();
+
+			game_state_t game_state;
+			player_strategies_t strategies;
+
+			while (next_game < games.end()) {
+				auto const chunk_end = std::min(games.end(), next_game + games_per_chunk);
+
+				simulation_measurement_t const measurement;
+				for (auto g = next_game; g < chunk_end; ++g) {
+					if (std::ranges::find(skip_games, g) != skip_games.end()) {
+						continue;
+					}
+					slot.current_game.store(g, std::memory_order_relaxed);
+					auto const seed = game_seed(base_seed, g);
+					random_t random{seed};
+					simulate_game(game_state, strategies, random, max_rounds, invariant_check_t::sample(g, g, seed));
+					// So a crash between games (e.g. while saving the snapshot) isn't blamed on this one.
+					slot.current_game.store(process_worker_slot_t::no_game, std::memory_order_relaxed);
+				}
+				measurement.record();
+
+				auto const target = 1u - slot.valid_snapshot.load(std::memory_order_relaxed);
+				slot.snapshots[target].next_game = chunk_end;
+				slot.snapshots[target].counters = stat_counters;
+				slot.valid_snapshot.store(target, std::memory_order_release);
+				next_game = chunk_end;
+			}
+
+			// Skip static destructors and stdio buffers inherited from the parent.
+			_exit(0);
+		}
+
+	}
+
+	inline process_pool_result_t run_seeded_simulations_process_pool(std::uint64_t const base_seed,
+			game_range_t const games, std::optional<unsigned> const max_rounds, unsigned const process_count,
+			std::uint64_t const games_per_chunk, std::size_t const max_failures) {
+		assert(process_count >= 1);
+		assert(games_per_chunk >= 1);
+
+		process_pool_result_t result;
+
+		auto const arena_size = sizeof(process_worker_slot_t) * process_count;
+		auto* const arena = mmap(nullptr, arena_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+		if (arena == MAP_FAILED) {
+			return result;
+		}
+		auto* const slots = static_cast<process_worker_slot_t*>(arena);
+
+		std::vector<game_range_t> worker_games(process_count);
+		for (unsigned i = 0; i < process_count; ++i) {
+			worker_games[i] = split_game_range(games, process_count, i);
+			auto* const slot = new (&slots[i]) process_worker_slot_t{};
+			slot->snapshots[0].next_game = worker_games[i].first;
+		}
+
+		// Games to skip, inherited by each worker when it's forked.
+		std::vector<std::uint64_t> skip_games;
+		std::vector<pid_t> worker_pids(process_count, -1);
+
+		auto const spawn_worker = [&](unsigned const i) {
+			// Otherwise buffered output would be written by both processes.
+			std::cout.flush();
+			std::cerr.flush();
+			auto const pid = fork();
+			if (pid == 0) {
+				detail::process_pool_worker(slots[i], base_seed, worker_games[i], max_rounds, games_per_chunk,
+					skip_games);
+			}
+			worker_pids[i] = pid;
+			return pid > 0;
+		};
+
+		auto const kill_workers = [&] {
+			for (auto& pid : worker_pids) {
+				if (pid > 0) {
+					kill(pid, SIGKILL);
+					waitpid(pid, nullptr, 0);
+					pid = -1;
+				}
+			}
+		};
+
+		bool ok = true;
+		for (unsigned i = 0; i < process_count && ok; ++i) {
+			ok = spawn_worker(i);
+		}
+
+		while (ok) {
+			auto const running = std::ranges::count_if(worker_pids, [](pid_t const pid) { return pid > 0; });
+			if (running == 0) {
+				break;
+			}
+
+			int status = 0;
+			auto const pid = waitpid(-1, &status, 0);
+			if (pid < 0) {
+				if (errno == EINTR) {
+					continue;
+				}
+				ok = false;
+				break;
+			}
+			auto const worker_it = std::ranges::find(worker_pids, pid);
+			if (worker_it == worker_pids.end()) {
+				continue;
+			}
+			auto const i = static_cast<unsigned>(worker_it - worker_pids.begin());
+			*worker_it = -1;
+
+			if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+				continue;
+			}
+
+			// Worker crashed.
+			auto const game = slots[i].current_game.load(std::memory_order_relaxed);
+			if (game == process_worker_slot_t::no_game || result.failed_games.size() >= max_failures) {
+				// Nothing to skip (so restarting won't help), or something is badly wrong.
+				ok = false;
+				break;
+			}
+			result.failed_games.push_back({
+				.game = game,
+				.seed = game_seed(base_seed, game),
+				.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0,
+				.exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : 0
+			});
+			skip_games.push_back(game);
+			slots[i].current_game.store(process_worker_slot_t::no_game, std::memory_order_relaxed);
+			ok = spawn_worker(i);
+		}
+
+		kill_workers();
+
+		// Statistics counters from workers are accumulated into the main thread's counters.
+		stat_counters = stat_counters_t{};
+		for (unsigned i = 0; i < process_count; ++i) {
+			auto const& slot = slots[i];
+			stat_counters += slot.snapshots[slot.valid_snapshot.load(std::memory_order_acquire)].counters;
+			slot.~process_worker_slot_t();
+		}
+		munmap(arena, arena_size);
+
+		std::ranges::sort(result.failed_games, {}, &failed_game_t::game);
+		result.completed = ok;
+		return result;
+	}
+
+#else
+
+	inline process_pool_result_t run_seeded_simulations_process_pool(std::uint64_t, game_range_t,
+			std::optional<unsigned>, unsigned, std::uint64_t, std::size_t) {
+		return {};
+	}
+
+#endif
+
+}
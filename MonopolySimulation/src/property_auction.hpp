@@ -1,10 +1,13 @@
 #pragma once
 
 #include <algorithm>
+#include <optional>
 
 #include "common_constants.hpp"
 #include "common_types.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "property_buy.hpp"
 #include "random.hpp"
@@ -25,6 +28,8 @@ namespace monopoly {
 		//   - The auction ends when there is a round where no player changes their bid.
 		//   - If multiple players have bid the same price, the property is not sold.
 
+		scoped_phase_timer const timer{profile_phase_t::auction};
+
 		auction_state_t auction_state;
 
 		while (true) {
@@ -49,17 +54,23 @@ namespace monopoly {
 
 		auto const best_bid_it = std::ranges::max_element(auction_state.bids);
 		auto const best_bid_price = *best_bid_it;
+		auto const best_bid_count = std::ranges::count(auction_state.bids, best_bid_price);
+		auto const best_bid_player = static_cast<unsigned>(best_bid_it - auction_state.bids.cbegin());
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			auto const winner = best_bid_price != 0 && best_bid_count == 1 ? std::optional{best_bid_player}
+				: std::nullopt;
+			game_state.event_trace->auction(game_state, property, winner, best_bid_price);
+		}
 		if (best_bid_price != 0) {
-			auto const best_bid_count = std::ranges::count(auction_state.bids, best_bid_price);
 			if (best_bid_count == 1) {
-				auto const best_bid_player = static_cast<unsigned>(best_bid_it - auction_state.bids.cbegin());
 				buy_unowned_property(game_state, best_bid_player, property, best_bid_price);
 
-				if (record_stats) {
+				if constexpr (record_stat_group<stat_group_t::auctions>) {
 					auto const property_idx = static_cast<unsigned>(property);
 					stat_counters.property_unowned_auction_price.get<P>()[property_idx] += best_bid_price;
 					stat_counters.property_unowned_auction_count.get<P>()[property_idx]++;
 					stat_counters.unowned_property_auctions_won[best_bid_player]++;
+					stat_counters.unowned_auction_price_histogram.add(best_bid_price);
 				}
 			}
 		}
@@ -4,7 +4,9 @@
 #include <utility>
 
 #include "cash_basic.hpp"
+#include "cohort_recording.hpp"
 #include "common_types.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
 #include "player_strategy.hpp"
 #include "property_values.hpp"
@@ -21,14 +23,22 @@ namespace monopoly {
 		assert(!game_state.property_ownership.get<P>().is_owned(property));
 		player_pay_bank_from_hand(game_state, player, cost);
 		game_state.property_ownership.get<P>().set_owner(property, player);
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->buy(game_state, player, property, cost);
+		}
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::property>) {
 			auto const property_idx = static_cast<unsigned>(property);
 			if (!std::exchange(stat_helper_state.property_has_been_purchased.get<P>()[property_idx], true)) {
 				stat_counters.property_purchased_at_least_once.get<P>()[property_idx]++;
 				stat_counters.property_first_purchase_round.get<P>()[property_idx] += game_state.round + 1;
 			}
 			stat_counters.property_purchase_costs[player] += cost;
+			game_state.stats.totals.property_purchase_costs[player] += cost;
+		}
+
+		if constexpr (record_stat_group<stat_group_t::cohorts>) {
+			record_purchase_cohort_features(game_state, player, property);
 		}
 	}
 
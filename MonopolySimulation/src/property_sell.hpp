@@ -22,8 +22,9 @@ namespace monopoly {
 		auto const sell_amount = property_sell_value(property);
 		bank_pay_player(game_state, player, sell_amount);
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::property>) {
 			stat_counters.property_sell_income[player] += sell_amount;
+			game_state.stats.totals.property_sell_income[player] += sell_amount;
 		}
 	}
 
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+
+namespace monopoly {
+
+	// Fixed size KLL quantile sketch (Karnin, Lang & Liberty), for distributions whose range isn't known in advance.
+	// Items are kept in levels, where an item at level h stands for 2^h samples. When the sketch is full, a level is
+	// sorted and every other item is promoted to the next level. Lower levels get geometrically smaller capacities, so
+	// memory is bounded while the rank error stays around 1.7/K.
+	// The compaction offset alternates deterministically per level instead of being random, so seeded runs are
+	// reproducible. Merging isn't associative, so results depend slightly on how samples were split between threads.
+	template<typename T, unsigned K = 128, unsigned MaxLevels = 30>
+		requires (K >= 8 && MaxLevels <= 32)
+	struct quantile_sketch {
+		static constexpr unsigned min_level_capacity = 8;
+
+		// Capacity of the level depth levels below the top.
+		[[nodiscard]]
+		static constexpr unsigned level_capacity(unsigned const depth) noexcept {
+			unsigned capacity = K;
+			for (unsigned i = 0; i < depth && capacity > min_level_capacity; ++i) {
+				capacity = capacity * 2 / 3;
+			}
+			return std::max(capacity, min_level_capacity);
+		}
+
+		[[nodiscard]]
+		static constexpr unsigned total_capacity(unsigned const levels) noexcept {
+			unsigned total = 0;
+			for (unsigned depth = 0; depth < levels; ++depth) {
+				total += level_capacity(depth);
+			}
+			return total;
+		}
+
+		// The sketch is compacted as soon as it exceeds its capacity, so it never holds more than one extra item.
+		static constexpr unsigned max_items = total_capacity(MaxLevels) + 1;
+
+		// Ordered from the highest level to level 0, so new samples are appended at the end.
+		std::array<T, max_items> items{};
+		std::array<std::uint32_t, MaxLevels> level_sizes{};
+		std::uint32_t level_count = 1;
+		std::uint32_t size = 0;
+		// Bit h is the offset of the next compaction of level h.
+		std::uint32_t compaction_parity = 0;
+		// Number of samples added.
+		std::uint64_t count = 0;
+		T min = std::numeric_limits<T>::max();
+		T max = std::numeric_limits<T>::lowest();
+
+		void add(T const value) noexcept {
+			++count;
+			min = std::min(min, value);
+			max = std::max(max, value);
+			insert(value, 0);
+		}
+
+		// Approximate value at quantile q (0 <= q <= 1). 0 if empty.
+		[[nodiscard]]
+		T quantile(double const q) const {
+			if (count == 0) {
+				return T{};
+			}
+			if (q <= 0) {
+				return min;
+			}
+			if (q >= 1) {
+				return max;
+			}
+
+			std::array<std::pair<T, std::uint64_t>, max_items> weighted{};
+			unsigned offset = 0;
+			for (unsigned h = level_count; h-- > 0;) {
+				for (unsigned i = 0; i < level_sizes[h]; ++i) {
+					weighted[offset + i] = {items[offset + i], std::uint64_t{1} << h};
+				}
+				offset += level_sizes[h];
+			}
+			std::sort(weighted.begin(), weighted.begin() + size);
+
+			auto const target = q * static_cast<double>(count);
+			std::uint64_t cumulative = 0;
+			for (unsigned i = 0; i < size; ++i) {
+				cumulative += weighted[i].second;
+				if (static_cast<double>(cumulative) >= target) {
+					return weighted[i].first;
+				}
+			}
+			return max;
+		}
+
+		// Whether the levels are consistent with the items held, e.g. after reading the sketch from a file.
+		[[nodiscard]]
+		bool is_valid() const noexcept {
+			if (level_count < 1 || level_count > MaxLevels || size > max_items) {
+				return false;
+			}
+			std::uint64_t total_size = 0;
+			for (unsigned h = 0; h < MaxLevels; ++h) {
+				if (h >= level_count && level_sizes[h] != 0) {
+					return false;
+				}
+				total_size += level_sizes[h];
+			}
+			return total_size == size;
+		}
+
+		quantile_sketch& operator+=(quantile_sketch const& other) {
+			unsigned offset = 0;
+			for (unsigned h = other.level_count; h-- > 0;) {
+				for (unsigned i = 0; i < other.level_sizes[h]; ++i) {
+					insert(other.items[offset + i], h);
+				}
+				offset += other.level_sizes[h];
+			}
+			count += other.count;
+			min = std::min(min, other.min);
+			max = std::max(max, other.max);
+			return *this;
+		}
+
+	private:
+		[[nodiscard]]
+		unsigned level_offset(unsigned const level) const noexcept {
+			unsigned offset = 0;
+			for (unsigned h = level + 1; h < level_count; ++h) {
+				offset += level_sizes[h];
+			}
+			return offset;
+		}
+
+		void insert(T const value, unsigned const level) noexcept {
+			assert(level < MaxLevels);
+			level_count = std::max(level_count, level + 1);
+			auto const position = level_offset(level) + level_sizes[level];
+			std::copy_backward(items.begin() + position, items.begin() + size, items.begin() + size + 1);
+			items[position] = value;
+			++level_sizes[level];
+			++size;
+
+			while (size > total_capacity(level_count)) {
+				// Some level must be over capacity. Compacting the lowest keeps the most weight in accurate levels.
+				unsigned h = 0;
+				while (level_sizes[h] < level_capacity(level_count - 1 - h)) {
+					++h;
+				}
+				compact(h);
+			}
+		}
+
+		void compact(unsigned const level) noexcept {
+			// Can't grow any further, the sketch was sized for more samples than can be counted in practice.
+			assert(level + 1 < MaxLevels);
+			if (level + 1 == level_count) {
+				++level_count;
+			}
+
+			auto const offset = level_offset(level);
+			auto const level_size = level_sizes[level];
+			auto const begin = items.begin() + offset;
+			std::sort(begin, begin + level_size);
+
+			auto const pairs = level_size / 2;
+			auto const parity = (compaction_parity >> level) & 1u;
+			compaction_parity ^= 1u << level;
+
+			// Level level + 1 ends where this level starts, so promoted items are written in place.
+			for (unsigned i = 0; i < pairs; ++i) {
+				begin[i] = begin[2 * i + parity];
+			}
+			// An odd item out stays on this level.
+			auto const remaining = level_size % 2;
+			if (remaining != 0) {
+				begin[pairs] = begin[level_size - 1];
+			}
+			std::copy(begin + level_size, items.begin() + size, begin + pairs + remaining);
+
+			level_sizes[level + 1] += pairs;
+			level_sizes[level] = remaining;
+			size -= pairs;
+		}
+	};
+
+}
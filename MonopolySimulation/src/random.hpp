@@ -79,4 +79,23 @@ namespace monopoly {
 		random_t& operator=(random_t const&) noexcept = default;
 	};
 
+
+	// Derives the seed of a single game from a base seed and the game's index, so that any game can be reproduced
+	// independently of how games are split between threads or processes.
+	// Based on the splitmix64 mixing function, from https://prng.di.unimi.it/splitmix64.c
+	[[nodiscard]]
+	constexpr std::uint64_t game_seed(std::uint64_t const base_seed, std::uint64_t const game_index) noexcept {
+		auto z = base_seed + (game_index + 1u) * 0x9e3779b97f4a7c15u;
+		z = (z ^ (z >> 30u)) * 0xbf58476d1ce4e5b9u;
+		z = (z ^ (z >> 27u)) * 0x94d049bb133111ebu;
+		return z ^ (z >> 31u);
+	}
+
+	// A pseudorandom index for sampling 1 in N games of an unseeded run, in place of the game's position in a thread's
+	// batch, which restarts with every batch.
+	[[nodiscard]]
+	constexpr std::uint64_t unseeded_sample_index(std::uint64_t const seed) noexcept {
+		return game_seed(seed, 1);
+	}
+
 }
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "common_constants.hpp"
+#include "game_analysis.hpp"
+#include "game_state.hpp"
+#include "random.hpp"
+#include "statistics_counters.hpp"
+
+
+// Bounded reservoirs of the most extreme games of a run (the longest, the fastest bankruptcy, ...), keeping each
+// game's seed so it can be replayed (--replay-game) instead of tracing every game.
+// Each thread keeps the top games of each criterion in a heap, and the heaps are merged when threads exit. A uniform
+// sample of ordinary games, for comparison, is kept the same way by ranking games on a hash of their seed, so every
+// reservoir merges exactly and the result doesn't depend on how games were split between threads.
+// Enabled at runtime (--rare-games K). Only threads of this process are covered, not process pool workers.
+namespace monopoly {
+
+	// Summary of a finished game. Values which depend on disabled statistic groups are nullopt.
+	struct rare_game_t {
+		// Seed of the game's random_t.
+		std::uint64_t seed = 0;
+		unsigned rounds = 0;
+		std::optional<std::uint64_t> turns;
+		std::optional<unsigned> first_bankruptcy_round;
+		std::optional<std::uint32_t> max_rent_payment;
+		// Largest amount by which the winner's net worth was behind the leader's. Requires the round_series group.
+		std::optional<unsigned long long> winner_comeback;
+	};
+
+	enum class rare_game_criterion_t : unsigned {
+		sample,
+		longest,
+		fastest_bankruptcy,
+		largest_rent,
+		largest_comeback
+	};
+
+	inline constexpr unsigned rare_game_criterion_count = 5;
+
+	inline constexpr std::array<std::string_view, rare_game_criterion_count> rare_game_criterion_names{
+		"sample",
+		"longest",
+		"fastest_bankruptcy",
+		"largest_rent",
+		"largest_comeback"
+	};
+
+	// Whether each criterion's statistics are recorded in this build.
+	inline constexpr std::array<bool, rare_game_criterion_count> rare_game_criterion_available{true, record_stats,
+		true, record_stat_group<stat_group_t::cash_flow>, record_stat_group<stat_group_t::round_series>};
+
+	struct rare_game_config_t {
+		// Games kept per criterion, 0 = disabled.
+		unsigned capacity = 0;
+		// By default, the criteria available in this build.
+		std::array<bool, rare_game_criterion_count> criteria = rare_game_criterion_available;
+	};
+
+	// Set before starting simulation threads.
+	inline rare_game_config_t rare_game_config;
+
+	[[nodiscard]]
+	inline rare_game_t summarise_rare_game(game_state_t const& game_state, std::uint64_t const seed) {
+		rare_game_t game{
+			.seed = seed,
+			.rounds = game_state.round,
+			.turns = std::nullopt,
+			.first_bankruptcy_round = std::nullopt,
+			.max_rent_payment = std::nullopt,
+			.winner_comeback = std::nullopt
+		};
+		auto const& totals = game_state.stats.totals;
+		if constexpr (record_stats) {
+			game.turns = totals.game_turns;
+		}
+		for (auto const& player_state : game_state.players) {
+			if (player_state.is_bankrupt()) {
+				game.first_bankruptcy_round = std::min(game.first_bankruptcy_round.value_or(
+					std::numeric_limits<unsigned>::max()), *player_state.bankrupt_round);
+			}
+		}
+		if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+			game.max_rent_payment = totals.max_rent_payment;
+		}
+		if constexpr (record_stat_group<stat_group_t::round_series>) {
+			// If players draw for first, the smallest comeback.
+			auto const ranks = rank_players(game_state);
+			for (auto const player : players) {
+				if (ranks[player] == 0) {
+					game.winner_comeback = std::min(game.winner_comeback.value_or(
+						std::numeric_limits<unsigned long long>::max()), totals.max_net_worth_deficit[player]);
+				}
+			}
+		}
+		return game;
+	}
+
+	// How extreme the game is under the criterion (higher is more extreme), or nullopt if it doesn't apply.
+	[[nodiscard]]
+	constexpr std::optional<std::uint64_t> rare_game_score(rare_game_t const& game,
+			rare_game_criterion_t const criterion) noexcept {
+		switch (criterion) {
+		case rare_game_criterion_t::sample:
+			// Pseudorandom, so the top games are a uniform sample.
+			return game_seed(game.seed, 0);
+		case rare_game_criterion_t::longest:
+			return game.turns;
+		case rare_game_criterion_t::fastest_bankruptcy:
+			if (!game.first_bankruptcy_round.has_value()) {
+				return std::nullopt;
+			}
+			return std::numeric_limits<unsigned>::max() - *game.first_bankruptcy_round;
+		case rare_game_criterion_t::largest_rent:
+			return game.max_rent_payment;
+		case rare_game_criterion_t::largest_comeback:
+			return game.winner_comeback;
+		}
+		return std::nullopt;
+	}
+
+
+	class rare_game_reservoir_t {
+	public:
+		void add(rare_game_t const& game) {
+			for (unsigned i = 0; i < rare_game_criterion_count; ++i) {
+				if (!rare_game_config.criteria[i]) {
+					continue;
+				}
+				auto const score = rare_game_score(game, static_cast<rare_game_criterion_t>(i));
+				if (score.has_value()) {
+					add(_heaps[i], {*score, game});
+				}
+			}
+		}
+
+		void merge(rare_game_reservoir_t const& other) {
+			for (unsigned i = 0; i < rare_game_criterion_count; ++i) {
+				for (auto const& entry : other._heaps[i]) {
+					add(_heaps[i], entry);
+				}
+			}
+		}
+
+		// Kept games of the criterion, most extreme first.
+		[[nodiscard]]
+		std::vector<rare_game_t> games(rare_game_criterion_t const criterion) const {
+			auto entries = _heaps[static_cast<unsigned>(criterion)];
+			std::ranges::sort(entries, is_more_extreme);
+			std::vector<rare_game_t> result;
+			result.reserve(entries.size());
+			for (auto const& entry : entries) {
+				result.push_back(entry.game);
+			}
+			return result;
+		}
+
+	private:
+		struct entry_t {
+			std::uint64_t score;
+			rare_game_t game;
+		};
+
+		// Heaps with the least extreme kept game at the front.
+		std::array<std::vector<entry_t>, rare_game_criterion_count> _heaps;
+
+		// Ties are broken by seed, so the kept games don't depend on the order they were added in.
+		[[nodiscard]]
+		static bool is_more_extreme(entry_t const& lhs, entry_t const& rhs) noexcept {
+			return lhs.score != rhs.score ? lhs.score > rhs.score : lhs.game.seed < rhs.game.seed;
+		}
+
+		static void add(std::vector<entry_t>& heap, entry_t const& entry) {
+			if (heap.size() < rare_game_config.capacity) {
+				heap.push_back(entry);
+				std::ranges::push_heap(heap, is_more_extreme);
+			}
+			else if (!heap.empty() && is_more_extreme(entry, heap.front())) {
+				std::ranges::pop_heap(heap, is_more_extreme);
+				heap.back() = entry;
+				std::ranges::push_heap(heap, is_more_extreme);
+			}
+		}
+	};
+
+	namespace rare_games_detail {
+
+		inline std::mutex exited_threads_mutex;
+		inline rare_game_reservoir_t exited_threads_games;
+
+		struct thread_games_t {
+			rare_game_reservoir_t games;
+
+			~thread_games_t() {
+				std::lock_guard const lock{exited_threads_mutex};
+				exited_threads_games.merge(games);
+			}
+		};
+
+		thread_local inline thread_games_t thread_games;
+
+	}
+
+	// Adds a finished game to the calling thread's reservoirs, if enabled.
+	inline void record_rare_game(game_state_t const& game_state, std::uint64_t const seed) {
+		if (rare_game_config.capacity > 0) {
+			rare_games_detail::thread_games.games.add(summarise_rare_game(game_state, seed));
+		}
+	}
+
+	// Reservoirs of all exited threads plus the calling thread.
+	[[nodiscard]]
+	inline rare_game_reservoir_t collect_rare_games() {
+		std::lock_guard const lock{rare_games_detail::exited_threads_mutex};
+		auto games = rare_games_detail::exited_threads_games;
+		games.merge(rare_games_detail::thread_games.games);
+		return games;
+	}
+
+}
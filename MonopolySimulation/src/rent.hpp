@@ -1,10 +1,14 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 
 #include "cash.hpp"
 #include "common_types.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
 #include "rent_constants.hpp"
@@ -82,6 +86,7 @@ namespace monopoly {
 	template<PropertyType P>
 	void pay_rent(game_state_t& game_state, player_strategies_t& strategies, random_t& random, unsigned const player,
 			P const property) {
+		scoped_phase_timer const timer{profile_phase_t::rent};
 		auto const owner = game_state.property_ownership.get<P>().get_owner(property);
 		assert(owner.has_value());
 		if (*owner != player) {
@@ -92,13 +97,19 @@ namespace monopoly {
 			else {
 				rent = calculate_rent(game_state, property);
 			}
+			if (game_state.event_trace != nullptr) [[unlikely]] {
+				game_state.event_trace->rent(game_state, player, property, *owner, rent);
+			}
 			player_pay_player(game_state, strategies, random, player, *owner, rent);
 
-			if constexpr (record_stats) {
-				stat_counters.rent_paid_amount[player] += rent;
-				stat_counters.rent_received_amount[*owner] += rent;
-				stat_counters.rent_paid_count[player]++;
-				stat_counters.rent_received_count[*owner]++;
+			if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+				game_state.stats.rent_paid_amount[player] += rent;
+				game_state.stats.rent_received_amount[*owner] += rent;
+				game_state.stats.rent_paid_count[player]++;
+				game_state.stats.rent_received_count[*owner]++;
+				game_state.stats.rent_payment_histogram.add(rent);
+				auto& max_rent_payment = game_state.stats.totals.max_rent_payment;
+				max_rent_payment = std::max<std::uint32_t>(max_rent_payment, rent);
 			}
 		}
 	}
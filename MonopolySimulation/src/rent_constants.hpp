@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 
 
@@ -46,4 +47,19 @@ namespace monopoly {
 	// Customisable.
 	inline constexpr std::array<unsigned, 2> utility_rent_dice_multiplier{4, 10};
 
+
+	// Upper bound on a single rent payment. Not customisable, derived from the above.
+	// Unbuilt streets in a full colour set pay multiplied rent, railways may be doubled by a Chance card, and
+	// utilities are at most 12 times the multiplier.
+	inline constexpr unsigned max_single_rent = [] {
+		unsigned max_rent = 0;
+		for (auto const& rents : street_rents) {
+			max_rent = std::max(max_rent, std::ranges::max(rents));
+			max_rent = std::max(max_rent, rents.front() * full_colour_set_rent_multiplier);
+		}
+		max_rent = std::max(max_rent, railway_rents.back() * 2);
+		max_rent = std::max(max_rent, 12 * utility_rent_dice_multiplier.back());
+		return max_rent;
+	}();
+
 }
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "cpu_time.hpp"
+#include "game_range.hpp"
+#include "math.hpp"
+#include "multithreading.hpp"
+#include "player_strategy.hpp"
+#include "simulation.hpp"
+#include "statistics_counters.hpp"
+
+
+namespace monopoly {
+
+	struct scaling_measurement_t {
+		unsigned threads = 0;
+		double wall_seconds = 0;
+		double cpu_seconds = 0;
+		// Time each thread spent running games.
+		std::vector<double> thread_seconds;
+		std::uint64_t turns = 0;
+
+		// Slowest thread relative to the average, i.e. 1 if the work is perfectly balanced.
+		[[nodiscard]]
+		double imbalance() const {
+			auto const total = std::reduce(thread_seconds.cbegin(), thread_seconds.cend(), 0.0);
+			return div(std::ranges::max(thread_seconds) * thread_seconds.size(), total);
+		}
+	};
+
+	// Runs the same seeded games on each thread count, so every measurement does identical work.
+	[[nodiscard]]
+	inline std::vector<scaling_measurement_t> run_scaling_benchmark(std::uint64_t const base_seed,
+			game_range_t const games, std::optional<unsigned> const max_rounds,
+			std::vector<unsigned> const& thread_counts) {
+		std::vector<scaling_measurement_t> measurements;
+
+		for (auto const threads : thread_counts) {
+			scaling_measurement_t measurement{.threads = threads, .thread_seconds = std::vector<double>(threads)};
+			std::vector<stat_counters_t> thread_counters(threads);
+
+			auto const thread_func = [&](unsigned const thread_index) {
+				player_strategies_t strategies;
+				stat_counters = stat_counters_t{};
+				run_seeded_simulations(strategies, base_seed, split_game_range(games, threads, thread_index),
+					max_rounds);
+				thread_counters[thread_index] = stat_counters;
+			};
+
+			auto const cpu_start = process_cpu_seconds();
+			auto const wall_start = std::chrono::steady_clock::now();
+			run_multithreaded(thread_func, threads);
+			std::chrono::duration<double> const wall_time = std::chrono::steady_clock::now() - wall_start;
+			measurement.cpu_seconds = process_cpu_seconds() - cpu_start;
+			measurement.wall_seconds = wall_time.count();
+
+			for (unsigned i = 0; i < threads; ++i) {
+				measurement.thread_seconds[i] = thread_counters[i].simulation_time_seconds;
+				measurement.turns += sum(thread_counters[i].turns_played);
+			}
+			measurements.push_back(std::move(measurement));
+		}
+
+		return measurements;
+	}
+
+	// 1, 2, 4, ... up to and including max_threads.
+	[[nodiscard]]
+	inline std::vector<unsigned> scaling_thread_counts(unsigned const max_threads) {
+		std::vector<unsigned> counts;
+		for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+			counts.push_back(threads);
+		}
+		counts.push_back(max_threads);
+		return counts;
+	}
+
+}
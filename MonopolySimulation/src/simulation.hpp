@@ -1,50 +1,172 @@
 #pragma once
 
+#include <algorithm>
+#include <barrier>
 #include <chrono>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <numeric>
 #include <optional>
+#include <utility>
+#include <vector>
 
+#include "checkpoint.hpp"
+#include "convergence.hpp"
+#include "event_trace.hpp"
 #include "game_analysis.hpp"
 #include "game_core.hpp"
+#include "game_observer.hpp"
+#include "game_output.hpp"
+#include "game_range.hpp"
 #include "game_state.hpp"
+#include "hardware_counters.hpp"
+#include "interleaved_simulation.hpp"
+#include "invariant_check.hpp"
+#include "math.hpp"
 #include "multithreading.hpp"
 #include "player_strategy.hpp"
 #include "random.hpp"
+#include "rare_games.hpp"
 #include "statistics_counters.hpp"
 
 
 namespace monopoly {
 
+	// Runs a single game and records its statistics.
+	// If event_trace is given (begun for this game), the game's events are recorded to it and it's ended.
+	// If turn_hook is given, it's called after every turn.
+	inline void simulate_game(game_state_t& game_state, player_strategies_t& strategies, random_t& random,
+			std::optional<unsigned> const max_rounds = std::nullopt,
+			std::optional<invariant_check_t> const& invariant_check = std::nullopt,
+			event_trace_t* const event_trace = nullptr, turn_hook_t* const turn_hook = nullptr) {
+		stat_helper_state = stat_helper_state_t{};
+		run_new_game(game_state, strategies, random, max_rounds, invariant_check ? &*invariant_check : nullptr,
+			event_trace, turn_hook);
+		if (event_trace != nullptr) {
+			event_trace->end_game(game_state);
+		}
+		game_end_analysis(game_state);
+	}
+
+	// Measures the time and hardware counters of simulating games on the calling thread, from construction until
+	// record() is called, which adds them to stat_counters.
+	class simulation_measurement_t {
+	public:
+		simulation_measurement_t() noexcept :
+			_start_turns{sum(stat_counters.turns_played)},
+			_start_hardware_counters{read_thread_hardware_counters()},
+			_start_time{std::chrono::steady_clock::now()}
+		{}
+
+		void record() const noexcept {
+			auto const end_time = std::chrono::steady_clock::now();
+			auto const hardware_counters = hardware_counter_difference(_start_hardware_counters,
+				read_thread_hardware_counters());
+			if constexpr (record_stats) {
+				using float_seconds = std::chrono::duration<double>;
+				stat_counters.simulation_time_seconds +=
+					std::chrono::duration_cast<float_seconds>(end_time - _start_time).count();
+
+				auto const turns = sum(stat_counters.turns_played) - _start_turns;
+				for (unsigned i = 0; i < hardware_counter_count; ++i) {
+					if (hardware_counters[i].has_value()) {
+						stat_counters.hardware_counter_values[i] += *hardware_counters[i];
+						stat_counters.hardware_counter_turns[i] += turns;
+					}
+				}
+			}
+		}
+
+	private:
+		int_count _start_turns;
+		hardware_counter_values_t _start_hardware_counters;
+		std::chrono::steady_clock::time_point _start_time;
+	};
+
 	// Runs a number of games for the purposes of collecting statistics.
+	// Each game is seeded from random, so that any game can be replayed from its seed.
 	inline void run_simulations(player_strategies_t& strategies, random_t& random, std::size_t const game_count,
 			std::optional<unsigned> const max_rounds = std::nullopt) {
 		game_state_t game_state;
 
-		auto const start_time = std::chrono::steady_clock::now();
-		for (std::size_t g = 0; g < game_count; ++g) {
-			stat_helper_state = stat_helper_state_t{};
-			run_new_game(game_state, strategies, random, max_rounds);
-			game_end_analysis(game_state);
+		simulation_measurement_t const measurement;
+		for (std::size_t i = 0; i < game_count; ++i) {
+			auto const seed = random();
+			random_t game_random{seed};
+			auto const sample_index = unseeded_sample_index(seed);
+			simulate_game(game_state, strategies, game_random, max_rounds,
+				invariant_check_t::sample(sample_index, std::nullopt, seed),
+				begin_sampled_event_trace(sample_index, seed));
+			record_rare_game(game_state, seed);
+		}
+		measurement.record();
+	}
+
+	// Runs the games in a range, with each game seeded from its index.
+	// The results don't depend on how the games are split between threads or processes.
+	inline void run_seeded_simulations(player_strategies_t& strategies, std::uint64_t const base_seed,
+			game_range_t const games, std::optional<unsigned> const max_rounds = std::nullopt) {
+		game_state_t game_state;
+		auto const observer = seeded_game_observer;
+
+		simulation_measurement_t const measurement;
+		for (auto g = games.first; g < games.end(); ++g) {
+			auto const seed = game_seed(base_seed, g);
+			random_t random{seed};
+			simulate_game(game_state, strategies, random, max_rounds, invariant_check_t::sample(g, g, seed),
+				begin_sampled_event_trace(g, seed), observer != nullptr ? observer->turn_hook(g) : nullptr);
+			if (observer != nullptr) {
+				observer->after_game(g, game_state);
+			}
+			record_rare_game(game_state, seed);
+			if (game_output_producer != nullptr) {
+				game_output_producer->push(make_game_record(game_state, g, seed));
+			}
 		}
-		auto const end_time = std::chrono::steady_clock::now();
+		measurement.record();
+	}
+
+	// Runs the games in a range with up to interleave games in progress at once, each seeded from its index.
+	// Records the same statistics as run_seeded_simulations(), since each game is played with the full scalar logic.
+	inline void run_seeded_simulations_interleaved(std::uint64_t const base_seed,
+			game_range_t const games, std::optional<unsigned> const max_rounds, unsigned const interleave) {
+		assert(interleave >= 1);
 
-		if constexpr (record_stats) {
-			using float_seconds = std::chrono::duration<double>;
-			stat_counters.simulation_time_seconds =
-				std::chrono::duration_cast<float_seconds>(end_time - start_time).count();
+		// Game states are large, so keep them out of the stack.
+		std::vector<std::unique_ptr<interleaved_game_t>> slots;
+		auto next_game = games.first;
+		for (unsigned i = 0; i < interleave && next_game < games.end(); ++i, ++next_game) {
+			slots.push_back(std::make_unique<interleaved_game_t>());
+			slots.back()->start(next_game, game_seed(base_seed, next_game));
+		}
+
+		simulation_measurement_t const measurement;
+		while (!slots.empty()) {
+			for (std::size_t i = 0; i < slots.size();) {
+				if (!slots[i]->step(max_rounds)) {
+					++i;
+				}
+				else if (next_game < games.end()) {
+					slots[i]->start(next_game, game_seed(base_seed, next_game));
+					++next_game;
+					++i;
+				}
+				else {
+					// No games left to start, so stop advancing this slot.
+					slots.erase(slots.begin() + static_cast<std::ptrdiff_t>(i));
+				}
+			}
 		}
+		measurement.record();
 	}
 
+
 	inline void run_simulations_multithreaded(auto strategies_factory, auto random_factory, std::size_t game_count,
 			std::optional<unsigned> const max_rounds = std::nullopt, std::optional<unsigned> threads = std::nullopt) {
 		if (!threads.has_value()) {
-			auto const hw_threads = std::thread::hardware_concurrency();
-			if (hw_threads > 0) {
-				threads = hw_threads;
-			}
-			else {
-				threads = 4;
-			}
+			threads = default_thread_count();
 		}
 
 		const auto games_per_thread = game_count / threads.value();
@@ -63,4 +185,179 @@ namespace monopoly {
 		stat_counters = map_multithreaded<stat_counters_t>(thread_func, threads.value());
 	}
 
+	// Runs a range of seeded games, split evenly between threads.
+	// If game_output is given, it must have a producer for each thread, and a record of every game is pushed to it.
+	inline void run_seeded_simulations_multithreaded(auto strategies_factory, std::uint64_t const base_seed,
+			game_range_t const games, std::optional<unsigned> const max_rounds = std::nullopt,
+			std::optional<unsigned> threads = std::nullopt, unsigned const interleave = 1,
+			game_output_writer_t* const game_output = nullptr) {
+		if (!threads.has_value()) {
+			threads = default_thread_count();
+		}
+
+		std::vector<stat_counters_t> thread_counters(threads.value());
+
+		auto const thread_func = [&](unsigned const thread_index) {
+			player_strategies_t strategies{strategies_factory()};
+			stat_counters = stat_counters_t{};
+
+			auto const thread_games = split_game_range(games, threads.value(), thread_index);
+			game_output_producer = game_output != nullptr ? &game_output->producer(thread_index) : nullptr;
+			if (interleave > 1) {
+				run_seeded_simulations_interleaved(base_seed, thread_games, max_rounds, interleave);
+			}
+			else {
+				run_seeded_simulations(strategies, base_seed, thread_games, max_rounds);
+			}
+			game_output_producer = nullptr;
+
+			thread_counters[thread_index] = stat_counters;
+		};
+
+		run_multithreaded(thread_func, threads.value());
+
+		// Statistics counters from threads are accumulated into the main thread's counters.
+		stat_counters = std::reduce(thread_counters.cbegin(), thread_counters.cend(), stat_counters_t{});
+	}
+
+
+
+	// Limits on how long run_simulations_until_converged() may run for if the targets aren't reached.
+	struct simulation_budget_t {
+		std::optional<std::size_t> max_games;
+		std::optional<double> max_seconds;
+	};
+
+	// Runs games in chunks until the convergence criteria are satisfied or the budget is exhausted.
+	// Convergence is checked whenever every thread has finished a chunk of games_per_chunk games. If the remaining
+	// game budget is smaller than a chunk, it's split between the threads as evenly as possible (so some threads may
+	// have no games).
+	// Return value indicates if the criteria were satisfied.
+	inline bool run_simulations_until_converged(auto strategies_factory, auto random_factory,
+			convergence_criteria_t const& criteria, simulation_budget_t const budget, std::size_t const games_per_chunk,
+			std::optional<unsigned> const max_rounds = std::nullopt, std::optional<unsigned> threads = std::nullopt) {
+		assert(games_per_chunk >= 1);
+		if (!threads.has_value()) {
+			threads = default_thread_count();
+		}
+
+		// Cumulative statistics from each thread, published at the end of each chunk.
+		std::vector<stat_counters_t> thread_counters(threads.value());
+		// Games in the next chunk, over all threads.
+		// Only modified by the barrier completion step, so visible to all threads after the barrier.
+		std::size_t next_chunk_games = games_per_chunk * threads.value();
+		bool done = false;
+		bool converged = false;
+
+		if (budget.max_games.has_value()) {
+			next_chunk_games = std::min(next_chunk_games, *budget.max_games);
+			done = next_chunk_games == 0;
+		}
+
+		auto const start_time = std::chrono::steady_clock::now();
+		auto const on_chunk_done = [&]() noexcept {
+			auto const total = std::reduce(thread_counters.cbegin(), thread_counters.cend(), stat_counters_t{});
+			converged = is_converged(total, criteria);
+			done = converged;
+
+			if (budget.max_games.has_value()) {
+				auto const remaining_games = *budget.max_games - std::min<std::size_t>(total.games, *budget.max_games);
+				next_chunk_games = std::min(games_per_chunk * threads.value(), remaining_games);
+				done = done || next_chunk_games == 0;
+			}
+
+			if (budget.max_seconds.has_value()) {
+				using float_seconds = std::chrono::duration<double>;
+				auto const elapsed = std::chrono::duration_cast<float_seconds>(
+					std::chrono::steady_clock::now() - start_time).count();
+				done = done || elapsed >= *budget.max_seconds;
+			}
+		};
+		std::barrier chunk_barrier{static_cast<std::ptrdiff_t>(threads.value()), on_chunk_done};
+
+		auto const thread_func = [&](unsigned const thread_index) {
+			random_t random{random_factory()};
+			player_strategies_t strategies{strategies_factory()};
+			stat_counters = stat_counters_t{};
+
+			while (!done) {
+				auto const thread_games = split_game_range({0, next_chunk_games}, threads.value(), thread_index);
+				run_simulations(strategies, random, thread_games.count, max_rounds);
+				thread_counters[thread_index] = stat_counters;
+				chunk_barrier.arrive_and_wait();
+			}
+		};
+
+		run_multithreaded(thread_func, threads.value());
+
+		// Statistics counters from threads are accumulated into the main thread's counters.
+		stat_counters = std::reduce(thread_counters.cbegin(), thread_counters.cend(), stat_counters_t{});
+		return converged;
+	}
+
+
+	// Runs (or continues) the seeded run described by the checkpoint, updating it as games are completed.
+	// Each thread runs its own part of the games in chunks of games_per_chunk. save_checkpoint(checkpoint) is called
+	// after a chunk if at least save_interval has passed since the last save, and once more at the end. Every
+	// thread's progress in a saved checkpoint is at a chunk boundary. Periodic saves are of a copy of the checkpoint,
+	// so other threads can carry on while it's written, and only one is in progress at a time.
+	inline void run_seeded_simulations_checkpointed(auto strategies_factory, checkpoint_t& checkpoint,
+			std::uint64_t const games_per_chunk, std::chrono::steady_clock::duration const save_interval,
+			auto save_checkpoint) {
+		assert(games_per_chunk >= 1);
+		assert(!checkpoint.workers.empty());
+		auto const max_rounds = checkpoint.max_rounds > 0 ? std::optional{checkpoint.max_rounds} : std::nullopt;
+
+		std::mutex checkpoint_mutex;
+		auto last_save_time = std::chrono::steady_clock::now();
+		bool saving = false;
+
+		auto const thread_func = [&](unsigned const thread_index) {
+			player_strategies_t strategies{strategies_factory()};
+
+			game_range_t remaining_games;
+			{
+				std::scoped_lock const lock{checkpoint_mutex};
+				auto const& worker = checkpoint.workers[thread_index];
+				stat_counters = worker.counters;
+				remaining_games = {worker.next_game, worker.games.end() - worker.next_game};
+			}
+
+			while (remaining_games.count > 0) {
+				game_range_t const chunk{remaining_games.first, std::min(games_per_chunk, remaining_games.count)};
+				run_seeded_simulations(strategies, checkpoint.base_seed, chunk, max_rounds);
+				remaining_games = {chunk.end(), remaining_games.count - chunk.count};
+
+				std::optional<checkpoint_t> snapshot;
+				{
+					std::scoped_lock const lock{checkpoint_mutex};
+					auto& worker = checkpoint.workers[thread_index];
+					worker.next_game = chunk.end();
+					worker.counters = stat_counters;
+					auto const now = std::chrono::steady_clock::now();
+					if (!saving && now - last_save_time >= save_interval) {
+						snapshot = checkpoint;
+						saving = true;
+						last_save_time = now;
+					}
+				}
+				if (snapshot.has_value()) {
+					save_checkpoint(std::as_const(*snapshot));
+					std::scoped_lock const lock{checkpoint_mutex};
+					saving = false;
+				}
+			}
+		};
+
+		run_multithreaded(thread_func, static_cast<unsigned>(checkpoint.workers.size()));
+
+		save_checkpoint(std::as_const(checkpoint));
+
+		// Statistics counters from threads are accumulated into the main thread's counters.
+		stat_counters = stat_counters_t{};
+		for (auto const& worker : checkpoint.workers) {
+			stat_counters += worker.counters;
+		}
+	}
+
 }
@@ -0,0 +1,67 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+
+namespace monopoly {
+
+	// Fixed capacity lock-free queue for exactly one producer thread and one consumer thread.
+	template<typename T, std::size_t Capacity>
+	class spsc_ring_t {
+	public:
+		static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of 2");
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		// Producer only. Returns false if the ring is full.
+		bool try_push(T const& value) noexcept {
+			auto const head = _head.load(std::memory_order_relaxed);
+			if (head - _cached_tail == Capacity) {
+				_cached_tail = _tail.load(std::memory_order_acquire);
+				if (head - _cached_tail == Capacity) {
+					return false;
+				}
+			}
+			_buffer[head & (Capacity - 1)] = value;
+			_head.store(head + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer only. Passes up to max_count values to func(value), oldest first.
+		// Returns the number of values consumed.
+		std::size_t consume(auto&& func, std::size_t const max_count = Capacity) {
+			auto const tail = _tail.load(std::memory_order_relaxed);
+			auto const head = _head.load(std::memory_order_acquire);
+			auto const count = head - tail < max_count ? head - tail : max_count;
+			for (std::size_t i = 0; i < count; ++i) {
+				func(std::as_const(_buffer[(tail + i) & (Capacity - 1)]));
+			}
+			_tail.store(tail + count, std::memory_order_release);
+			return count;
+		}
+
+		// Consumer only. Only a snapshot if the producer is still running.
+		[[nodiscard]]
+		bool empty() const noexcept {
+			return _head.load(std::memory_order_acquire) == _tail.load(std::memory_order_relaxed);
+		}
+
+	private:
+		// The producer and consumer indices are on separate cache lines, so each thread only writes its own line.
+		// Indices increase indefinitely and are wrapped when accessing the buffer.
+		static constexpr std::size_t cache_line_size = 64;
+
+		// Written by the producer.
+		alignas(cache_line_size) std::atomic<std::size_t> _head{0};
+		// Producer's last view of _tail, to avoid touching the consumer's cache line on every push.
+		std::size_t _cached_tail = 0;
+		// Written by the consumer.
+		alignas(cache_line_size) std::atomic<std::size_t> _tail{0};
+		alignas(cache_line_size) std::array<T, Capacity> _buffer{};
+	};
+
+}
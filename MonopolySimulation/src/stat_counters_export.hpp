@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <concepts>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+#include <ostream>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#include "statistics_counters.hpp"
+
+
+// Text export of stat_counters_t for analysis in other tools, generated from stat_counter_registry.
+// Counters of statistic groups disabled in this build are omitted.
+namespace monopoly {
+
+	namespace stat_export_detail {
+
+		inline constexpr std::array<std::pair<std::string_view, double>, 5> sketch_quantiles{{
+			{"min", 0.0}, {"p50", 0.5}, {"p90", 0.9}, {"p99", 0.99}, {"max", 1.0}
+		}};
+
+		template<typename T>
+		void write_scalar(std::ostream& stream, T const value) {
+			if constexpr (std::floating_point<T>) {
+				// JSON has no representation of NaN or infinity.
+				if (!std::isfinite(value)) {
+					stream << "null";
+					return;
+				}
+			}
+			stream << value;
+		}
+
+		// Calls func(path, value) for every scalar within value, e.g. "board_space_counts[2][13]".
+		template<typename T>
+		void for_each_scalar(std::string const& path, T const& value, auto&& func) {
+			if constexpr (std::is_arithmetic_v<T>) {
+				func(path, value);
+			}
+			else if constexpr (std::same_as<T, moment_accumulator>) {
+				func(path + ".count", value.count);
+				func(path + ".mean", value.mean);
+				func(path + ".m2", value.m2);
+				func(path + ".min", value.min);
+				func(path + ".max", value.max);
+			}
+			// quantile_sketch: its items are only meaningful together, so export a summary instead.
+			else if constexpr (requires { value.quantile(0.5); }) {
+				func(path + ".count", value.count);
+				for (auto const& [name, q] : sketch_quantiles) {
+					func(path + '.' + std::string{name}, value.quantile(q));
+				}
+			}
+			// log2_histogram, log_linear_histogram
+			else if constexpr (requires { value.enumerate_bins([](auto, auto, auto) {}); }) {
+				for_each_scalar(path + ".bins", value.bins, func);
+			}
+			// per_propertytype_data
+			else if constexpr (requires { value.street; value.railway; value.utility; }) {
+				for_each_scalar(path + ".street", value.street, func);
+				for_each_scalar(path + ".railway", value.railway, func);
+				for_each_scalar(path + ".utility", value.utility, func);
+			}
+			else {
+				static_assert(std::ranges::range<T>, "Unsupported counter type");
+				std::size_t i = 0;
+				for (auto const& element : value) {
+					for_each_scalar(path + '[' + std::to_string(i) + ']', element, func);
+					++i;
+				}
+			}
+		}
+
+		template<typename T>
+		void write_json(std::ostream& stream, T const& value) {
+			if constexpr (std::is_arithmetic_v<T>) {
+				write_scalar(stream, value);
+			}
+			else if constexpr (std::same_as<T, moment_accumulator>) {
+				stream << "{\"count\": " << value.count << ", \"mean\": ";
+				write_scalar(stream, value.mean);
+				stream << ", \"m2\": ";
+				write_scalar(stream, value.m2);
+				stream << ", \"min\": ";
+				write_scalar(stream, value.min);
+				stream << ", \"max\": ";
+				write_scalar(stream, value.max);
+				stream << '}';
+			}
+			else if constexpr (requires { value.quantile(0.5); }) {
+				stream << "{\"count\": " << value.count;
+				for (auto const& [name, q] : sketch_quantiles) {
+					stream << ", \"" << name << "\": ";
+					write_scalar(stream, value.quantile(q));
+				}
+				stream << '}';
+			}
+			// log2_histogram, log_linear_histogram
+			else if constexpr (requires { value.enumerate_bins([](auto, auto, auto) {}); }) {
+				stream << "{\"bins\": ";
+				write_json(stream, value.bins);
+				stream << '}';
+			}
+			// per_propertytype_data
+			else if constexpr (requires { value.street; value.railway; value.utility; }) {
+				stream << "{\"street\": ";
+				write_json(stream, value.street);
+				stream << ", \"railway\": ";
+				write_json(stream, value.railway);
+				stream << ", \"utility\": ";
+				write_json(stream, value.utility);
+				stream << '}';
+			}
+			else {
+				static_assert(std::ranges::range<T>, "Unsupported counter type");
+				stream << '[';
+				bool first = true;
+				for (auto const& element : value) {
+					if (!first) {
+						stream << ", ";
+					}
+					first = false;
+					write_json(stream, element);
+				}
+				stream << ']';
+			}
+		}
+
+	}
+
+
+	// One "name,value" row per scalar.
+	inline void write_stat_counters_csv(std::ostream& stream, stat_counters_t const& counters) {
+		stream.precision(std::numeric_limits<double>::max_digits10);
+		stream << "name,value\n";
+		for_each_stat_counter([&stream, &counters](auto const& info) {
+			if (!is_stat_group_recorded(info.group)) {
+				return;
+			}
+			stat_export_detail::for_each_scalar(std::string{info.name}, counters.*info.member,
+				[&stream](std::string const& path, auto const value) {
+					stream << path << ',';
+					stat_export_detail::write_scalar(stream, value);
+					stream << '\n';
+				});
+		});
+	}
+
+	// One object with a member per counter, arrays nested as in stat_counters_t.
+	inline void write_stat_counters_json(std::ostream& stream, stat_counters_t const& counters) {
+		stream.precision(std::numeric_limits<double>::max_digits10);
+		stream << "{";
+		bool first = true;
+		for_each_stat_counter([&stream, &counters, &first](auto const& info) {
+			if (!is_stat_group_recorded(info.group)) {
+				return;
+			}
+			stream << (first ? "\n" : ",\n") << "\t\"" << info.name << "\": ";
+			first = false;
+			stat_export_detail::write_json(stream, counters.*info.member);
+		});
+		stream << "\n}\n";
+	}
+
+	enum class stat_export_format_t {
+		csv,
+		json
+	};
+
+	// Return value indicates success.
+	inline bool export_stat_counters(std::filesystem::path const& path, stat_export_format_t const format,
+			stat_counters_t const& counters) {
+		std::ofstream stream{path, std::ios::trunc};
+		if (!stream) {
+			return false;
+		}
+		switch (format) {
+		case stat_export_format_t::csv: write_stat_counters_csv(stream, counters); break;
+		case stat_export_format_t::json: write_stat_counters_json(stream, counters); break;
+		}
+		stream.flush();
+		return !stream.fail();
+	}
+
+}
@@ -0,0 +1,271 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <random>
+#include <ranges>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+#include "common_constants.hpp"
+#include "per_propertytype_data.hpp"
+#include "statistics_counters.hpp"
+
+
+// Versioned binary serialisation of stat_counters_t, used to combine results from multiple processes.
+// All values are stored little endian, independent of the host.
+namespace monopoly {
+
+	inline constexpr std::array<char, 8> stat_counters_file_magic{'M', 'O', 'N', 'O', 'S', 'T', 'A', 'T'};
+
+	// Must be incremented whenever the layout of stat_counters_t or the file changes.
+	inline constexpr std::uint32_t stat_counters_file_version = 8;
+
+
+	// Identifies which games contributed to a counters file.
+	// Games are numbered from 0, with seeds derived from base_seed with game_seed().
+	struct stat_counters_file_info_t {
+		std::uint64_t base_seed = 0;
+		std::uint64_t first_game = 0;
+		std::uint64_t game_count = 0;
+		std::uint32_t max_rounds = 0;		// 0 = no limit.
+
+		[[nodiscard]]
+		constexpr std::uint64_t end_game() const noexcept {
+			return first_game + game_count;
+		}
+	};
+
+
+	class binary_writer_t {
+	public:
+		explicit binary_writer_t(std::ostream& stream) noexcept :
+			_stream{&stream}
+		{}
+
+		template<std::unsigned_integral T>
+		void value(T const& value) {
+			std::array<char, sizeof(T)> bytes;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				bytes[i] = static_cast<char>((value >> (8 * i)) & 0xFFu);
+			}
+			_stream->write(bytes.data(), bytes.size());
+		}
+
+		void value(double const& value) {
+			this->value(std::bit_cast<std::uint64_t>(value));
+		}
+
+		[[nodiscard]]
+		bool ok() const {
+			return _stream->good();
+		}
+
+	private:
+		std::ostream* _stream;
+	};
+
+
+	class binary_reader_t {
+	public:
+		explicit binary_reader_t(std::istream& stream) noexcept :
+			_stream{&stream}
+		{}
+
+		template<std::unsigned_integral T>
+		void value(T& value) {
+			std::array<char, sizeof(T)> bytes{};
+			_stream->read(bytes.data(), bytes.size());
+			value = 0;
+			for (std::size_t i = 0; i < sizeof(T); ++i) {
+				value |= static_cast<T>(static_cast<unsigned char>(bytes[i])) << (8 * i);
+			}
+		}
+
+		void value(double& value) {
+			std::uint64_t bits{};
+			this->value(bits);
+			value = std::bit_cast<double>(bits);
+		}
+
+		[[nodiscard]]
+		bool ok() const {
+			return _stream->good();
+		}
+
+		// Fails the read, for values which were read successfully but are invalid.
+		void set_invalid() {
+			_stream->setstate(std::ios::failbit);
+		}
+
+	private:
+		std::istream* _stream;
+	};
+
+
+	// transfer() either writes or reads a value depending on the archive type, so that the file layout is only
+	// described once. T may be const-qualified when writing.
+
+	template<typename Archive, typename T> requires std::is_arithmetic_v<std::remove_const_t<T>>
+	void transfer(Archive& archive, T& value) {
+		archive.value(value);
+	}
+
+	template<typename Archive, std::ranges::range R>
+	void transfer(Archive& archive, R& range) {
+		for (auto& element : range) {
+			transfer(archive, element);
+		}
+	}
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, moment_accumulator>
+	void transfer(Archive& archive, T& moments) {
+		transfer(archive, moments.count);
+		transfer(archive, moments.mean);
+		transfer(archive, moments.m2);
+		transfer(archive, moments.min);
+		transfer(archive, moments.max);
+	}
+
+	// log2_histogram, log_linear_histogram
+	template<typename Archive, typename T> requires requires (T t) { t.enumerate_bins([](auto, auto, auto) {}); }
+	void transfer(Archive& archive, T& histogram) {
+		transfer(archive, histogram.bins);
+	}
+
+	template<typename Archive, typename T> requires requires (T t) { t.level_sizes; t.compaction_parity; }
+	void transfer(Archive& archive, T& sketch) {
+		transfer(archive, sketch.items);
+		transfer(archive, sketch.level_sizes);
+		transfer(archive, sketch.level_count);
+		transfer(archive, sketch.size);
+		transfer(archive, sketch.compaction_parity);
+		transfer(archive, sketch.count);
+		transfer(archive, sketch.min);
+		transfer(archive, sketch.max);
+		// The levels index into the items, so a corrupt file mustn't be trusted.
+		if constexpr (requires { archive.set_invalid(); }) {
+			if (!sketch.is_valid()) {
+				archive.set_invalid();
+			}
+		}
+	}
+
+	// per_propertytype_data
+	template<typename Archive, typename T> requires requires (T t) { t.street; t.railway; t.utility; }
+	void transfer(Archive& archive, T& data) {
+		transfer(archive, data.street);
+		transfer(archive, data.railway);
+		transfer(archive, data.utility);
+	}
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, stat_counters_file_info_t>
+	void transfer(Archive& archive, T& info) {
+		transfer(archive, info.base_seed);
+		transfer(archive, info.first_game);
+		transfer(archive, info.game_count);
+		transfer(archive, info.max_rounds);
+	}
+
+	template<typename Archive, typename T> requires std::same_as<std::remove_const_t<T>, stat_counters_t>
+	void transfer(Archive& archive, T& counters) {
+		// All counters are transferred regardless of the enabled statistic groups, so files are always compatible.
+		for_each_stat_counter([&archive, &counters](auto const& info) {
+			transfer(archive, counters.*info.member);
+		});
+	}
+
+
+	// Temporary path next to path, to write a file before renaming it into place. Unique to the writer, since
+	// several processes may write the same file at once (e.g. a work queue range which was run twice).
+	[[nodiscard]]
+	inline std::filesystem::path unique_temp_path(std::filesystem::path const& path) {
+		std::random_device random;
+		auto const suffix = (std::uint64_t{random()} << 32) | random();
+		auto temp_path = path;
+		temp_path += '.' + std::to_string(suffix) + ".tmp";
+		return temp_path;
+	}
+
+	// Writes the counters to a file. The file is written to a temporary location and then renamed, so readers never
+	// observe a partially written file.
+	// Return value indicates success.
+	inline bool write_stat_counters_file(std::filesystem::path const& path, stat_counters_file_info_t const& info,
+			stat_counters_t const& counters) {
+		auto const temp_path = unique_temp_path(path);
+		// Temporary files are removed on failure, since their names aren't reused.
+		std::error_code error;
+
+		{
+			std::ofstream stream{temp_path, std::ios::binary | std::ios::trunc};
+			if (!stream) {
+				return false;
+			}
+			stream.write(stat_counters_file_magic.data(), stat_counters_file_magic.size());
+			binary_writer_t writer{stream};
+			transfer(writer, stat_counters_file_version);
+			transfer(writer, player_count);
+			transfer(writer, info);
+			transfer(writer, counters);
+			stream.flush();
+			if (!writer.ok()) {
+				stream.close();
+				std::filesystem::remove(temp_path, error);
+				return false;
+			}
+		}
+
+		std::filesystem::rename(temp_path, path, error);
+		if (error) {
+			std::filesystem::remove(temp_path, error);
+			return false;
+		}
+		return true;
+	}
+
+	// Reads counters previously written with write_stat_counters_file().
+	// Return value indicates success. Fails if the file is from an incompatible version.
+	inline bool read_stat_counters_file(std::filesystem::path const& path, stat_counters_file_info_t& info,
+			stat_counters_t& counters) {
+		std::ifstream stream{path, std::ios::binary};
+		if (!stream) {
+			return false;
+		}
+
+		std::array<char, stat_counters_file_magic.size()> magic{};
+		stream.read(magic.data(), magic.size());
+		if (!stream || magic != stat_counters_file_magic) {
+			return false;
+		}
+
+		binary_reader_t reader{stream};
+		std::uint32_t version{};
+		std::uint32_t file_player_count{};
+		transfer(reader, version);
+		transfer(reader, file_player_count);
+		if (!reader.ok() || version != stat_counters_file_version || file_player_count != player_count) {
+			return false;
+		}
+
+		transfer(reader, info);
+		transfer(reader, counters);
+		if (!reader.ok()) {
+			return false;
+		}
+
+		// Should be nothing left over.
+		if (stream.peek() != std::ifstream::traits_type::eof()) {
+			return false;
+		}
+
+		return counters.games == info.game_count;
+	}
+
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <iostream>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "game_range.hpp"
+#include "stat_counters_io.hpp"
+#include "statistics_counters.hpp"
+
+
+namespace monopoly {
+
+	struct merged_stat_counters_t {
+		stat_counters_t counters;
+		std::uint64_t base_seed = 0;
+		std::uint32_t max_rounds = 0;
+		// Disjoint ranges of games which contributed, in ascending order. Adjacent ranges are coalesced.
+		std::vector<game_range_t> coverage;
+
+		[[nodiscard]]
+		bool is_contiguous() const noexcept {
+			return coverage.size() <= 1;
+		}
+
+		// Only meaningful if the coverage is contiguous.
+		[[nodiscard]]
+		stat_counters_file_info_t file_info() const noexcept {
+			stat_counters_file_info_t info{.base_seed = base_seed, .max_rounds = max_rounds};
+			if (!coverage.empty()) {
+				info.first_game = coverage.front().first;
+				info.game_count = coverage.back().end() - coverage.front().first;
+			}
+			return info;
+		}
+	};
+
+
+	// Reads and combines counters files produced from the same experiment.
+	// Fails (printing the reason) if any file can't be read, if the files are from different experiments, or if any
+	// games are counted more than once.
+	[[nodiscard]]
+	inline std::optional<merged_stat_counters_t> merge_stat_counters_files(
+			std::span<std::filesystem::path const> const paths) {
+		if (paths.empty()) {
+			std::cerr << "Error: no files to merge\n";
+			return std::nullopt;
+		}
+
+		merged_stat_counters_t result;
+		std::vector<game_range_t> ranges;
+		ranges.reserve(paths.size());
+
+		for (auto const& path : paths) {
+			stat_counters_file_info_t info;
+			stat_counters_t counters;
+			if (!read_stat_counters_file(path, info, counters)) {
+				std::cerr << "Error: failed to read counters file " << path << '\n';
+				return std::nullopt;
+			}
+
+			if (ranges.empty()) {
+				result.base_seed = info.base_seed;
+				result.max_rounds = info.max_rounds;
+			}
+			else if (info.base_seed != result.base_seed || info.max_rounds != result.max_rounds) {
+				std::cerr << "Error: " << path << " is from a different experiment (seed or max rounds differ)\n";
+				return std::nullopt;
+			}
+
+			result.counters += counters;
+			if (info.game_count > 0) {
+				ranges.push_back({info.first_game, info.game_count});
+			}
+		}
+
+		std::ranges::sort(ranges, {}, &game_range_t::first);
+		for (auto const& range : ranges) {
+			if (!result.coverage.empty() && range.first < result.coverage.back().end()) {
+				std::cerr << "Error: games from " << range.first << " are counted more than once\n";
+				return std::nullopt;
+			}
+			if (!result.coverage.empty() && range.first == result.coverage.back().end()) {
+				result.coverage.back().count += range.count;
+			}
+			else {
+				result.coverage.push_back(range);
+			}
+		}
+
+		return result;
+	}
+
+}
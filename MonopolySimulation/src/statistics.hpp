@@ -1,11 +1,14 @@
 #pragma once
 
 #include <array>
+#include <optional>
 
 #include "board_space_constants.hpp"
+#include "cohort_features.hpp"
 #include "common_constants.hpp"
 #include "common_types.hpp"
 #include "gameplay_constants.hpp"
+#include "hardware_counters.hpp"
 #include "math.hpp"
 #include "property_values.hpp"
 #include "statistics_counters.hpp"
@@ -13,6 +16,22 @@
 
 namespace monopoly {
 
+	struct quantile_summary_t {
+		double p50;
+		double p90;
+		double p99;
+	};
+
+	[[nodiscard]]
+	inline quantile_summary_t summarise_quantiles(auto const& sketch) {
+		return {
+			static_cast<double>(sketch.quantile(0.5)),
+			static_cast<double>(sketch.quantile(0.9)),
+			static_cast<double>(sketch.quantile(0.99))
+		};
+	}
+
+
 	class statistics_t {
 	public:
 		explicit constexpr statistics_t(stat_counters_t const& counters) noexcept :
@@ -34,6 +53,16 @@ namespace monopoly {
 			return div(sum(c->turns_played), c->simulation_time_seconds);
 		}
 		
+		// Average of a hardware counter per turn, if it was recorded.
+		[[nodiscard]]
+		std::optional<double> hardware_counter_per_turn(hardware_counter_t const counter) const {
+			auto const index = static_cast<unsigned>(counter);
+			if (c->hardware_counter_turns[index] == 0) {
+				return std::nullopt;
+			}
+			return div(c->hardware_counter_values[index], c->hardware_counter_turns[index]);
+		}
+
 		[[nodiscard]]
 		double avg_rounds_per_game() const {
 			return div(c->rounds, c->games);
@@ -59,6 +88,12 @@ namespace monopoly {
 			return div(c->turns_played[player] - 1, c->games);
 		}
 		
+		// Approximate, from a quantile sketch.
+		[[nodiscard]]
+		quantile_summary_t turns_per_game_quantiles() const {
+			return summarise_quantiles(c->turns_per_game_sketch);
+		}
+
 		[[nodiscard]]
 		std::array<double, board_space_count + 1> board_space_relative_frequencies(unsigned const player) const {
 			auto const total = sum(c->board_space_counts[player]);
@@ -133,6 +168,12 @@ namespace monopoly {
 			return div(c->rent_paid_amount[player], c->games);
 		}
 		
+		// Total over all players. Approximate, from a quantile sketch.
+		[[nodiscard]]
+		quantile_summary_t rent_per_game_quantiles() const {
+			return summarise_quantiles(c->rent_per_game_sketch);
+		}
+
 		[[nodiscard]]
 		double avg_rent_paid_per_turn(unsigned const player) const {
 			return div(c->rent_paid_amount[player], c->turns_played[player]);
@@ -242,6 +283,25 @@ namespace monopoly {
 			return div(c->unowned_property_auctions_won[player], c->games);
 		}
 
+		// Number of games ending with each rank, over the games in which the player had all of the required cohort
+		// features and none of the excluded ones. Summed over all players if player is not given.
+		[[nodiscard]]
+		per_player_int_count cohort_rank_counts(cohort_mask_t const required, cohort_mask_t const excluded,
+				std::optional<unsigned> const player = std::nullopt) const {
+			per_player_int_count counts{};
+			for (auto const p : players) {
+				if (player.has_value() && p != *player) {
+					continue;
+				}
+				for (unsigned mask = 0; mask < cohort_mask_count; ++mask) {
+					if ((mask & required) == required && (mask & excluded) == 0) {
+						counts += c->cohort_rank_counts[p][mask];
+					}
+				}
+			}
+			return counts;
+		}
+
 	private:
 		stat_counters_t const* c;
 	};
@@ -1,17 +1,136 @@
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <bit>
+#include <cmath>
 #include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
 
+#include "cohort_features.hpp"
 #include "common_constants.hpp"
+#include "gameplay_constants.hpp"
+#include "hardware_counters.hpp"
 #include "property_constants.hpp"
 #include "per_propertytype_data.hpp"
+#include "quantile_sketch.hpp"
+#include "rent_constants.hpp"
 
 
 namespace monopoly {
 
-	inline constexpr bool record_stats = true;
+#ifndef MONOPOLY_RECORD_STATS
+#define MONOPOLY_RECORD_STATS 1
+#endif
+
+// Each group can be disabled separately at build time (e.g. -DMONOPOLY_STATS_CARDS=0).
+#ifndef MONOPOLY_STATS_MOVEMENT
+#define MONOPOLY_STATS_MOVEMENT MONOPOLY_RECORD_STATS
+#endif
+#ifndef MONOPOLY_STATS_CASH_FLOW
+#define MONOPOLY_STATS_CASH_FLOW MONOPOLY_RECORD_STATS
+#endif
+#ifndef MONOPOLY_STATS_CARDS
+#define MONOPOLY_STATS_CARDS MONOPOLY_RECORD_STATS
+#endif
+#ifndef MONOPOLY_STATS_AUCTIONS
+#define MONOPOLY_STATS_AUCTIONS MONOPOLY_RECORD_STATS
+#endif
+#ifndef MONOPOLY_STATS_PROPERTY
+#define MONOPOLY_STATS_PROPERTY MONOPOLY_RECORD_STATS
+#endif
+#ifndef MONOPOLY_STATS_ENDGAME
+#define MONOPOLY_STATS_ENDGAME MONOPOLY_RECORD_STATS
+#endif
+// Off by default, since valuing every player's assets every round costs about a quarter of the throughput.
+#ifndef MONOPOLY_STATS_ROUND_SERIES
+#define MONOPOLY_STATS_ROUND_SERIES 0
+#endif
+#ifndef MONOPOLY_STATS_COHORTS
+#define MONOPOLY_STATS_COHORTS MONOPOLY_RECORD_STATS
+#endif
+
+	// Statistics can be disabled at build time (e.g. -DMONOPOLY_RECORD_STATS=0) to measure their cost.
+	// Covers the basic counters (games, rounds, turns, game length and simulation time), which the other groups
+	// depend on for normalisation.
+	inline constexpr bool record_stats = MONOPOLY_RECORD_STATS;
+
+	enum class stat_group_t {
+		// Games, rounds, turns, game length and simulation time. Controlled by record_stats only.
+		basic,
+		// Board space visits, passing Go, jail.
+		movement,
+		// Rent and jail fees.
+		cash_flow,
+		// Cards drawn and their cash effects.
+		cards,
+		// Auctions of unowned properties.
+		auctions,
+		// Property purchases and sales.
+		property,
+		// Final ranks and net worths.
+		endgame,
+		// Cash, net worth and properties of each player after each round. Opt-in (-DMONOPOLY_STATS_ROUND_SERIES=1).
+		round_series,
+		// Final ranks for each combination of per-game features.
+		cohorts
+	};
+
+	// Which statistic groups are recorded. Code for disabled groups is discarded at compile time.
+	struct build_stat_policy {
+		static constexpr bool movement = MONOPOLY_STATS_MOVEMENT;
+		static constexpr bool cash_flow = MONOPOLY_STATS_CASH_FLOW;
+		static constexpr bool cards = MONOPOLY_STATS_CARDS;
+		static constexpr bool auctions = MONOPOLY_STATS_AUCTIONS;
+		static constexpr bool property = MONOPOLY_STATS_PROPERTY;
+		static constexpr bool endgame = MONOPOLY_STATS_ENDGAME;
+		static constexpr bool round_series = MONOPOLY_STATS_ROUND_SERIES;
+		static constexpr bool cohorts = MONOPOLY_STATS_COHORTS;
+	};
+
+	template<typename Policy, stat_group_t G>
+	[[nodiscard]]
+	constexpr bool policy_records_group() noexcept {
+		switch (G) {
+		case stat_group_t::basic: return true;
+		case stat_group_t::movement: return Policy::movement;
+		case stat_group_t::cash_flow: return Policy::cash_flow;
+		case stat_group_t::cards: return Policy::cards;
+		case stat_group_t::auctions: return Policy::auctions;
+		case stat_group_t::property: return Policy::property;
+		case stat_group_t::endgame: return Policy::endgame;
+		case stat_group_t::round_series: return Policy::round_series;
+		case stat_group_t::cohorts: return Policy::cohorts;
+		}
+		return false;
+	}
+
+	using stat_policy = build_stat_policy;
+
+	// Groups are never recorded without the basic counters.
+	template<stat_group_t G>
+	inline constexpr bool record_stat_group = record_stats && policy_records_group<stat_policy, G>();
+
+	// Runtime equivalent of record_stat_group.
+	[[nodiscard]]
+	constexpr bool is_stat_group_recorded(stat_group_t const group) noexcept {
+		switch (group) {
+		case stat_group_t::basic: return record_stat_group<stat_group_t::basic>;
+		case stat_group_t::movement: return record_stat_group<stat_group_t::movement>;
+		case stat_group_t::cash_flow: return record_stat_group<stat_group_t::cash_flow>;
+		case stat_group_t::cards: return record_stat_group<stat_group_t::cards>;
+		case stat_group_t::auctions: return record_stat_group<stat_group_t::auctions>;
+		case stat_group_t::property: return record_stat_group<stat_group_t::property>;
+		case stat_group_t::endgame: return record_stat_group<stat_group_t::endgame>;
+		case stat_group_t::round_series: return record_stat_group<stat_group_t::round_series>;
+		case stat_group_t::cohorts: return record_stat_group<stat_group_t::cohorts>;
+		}
+		return false;
+	}
 
 
 	template<typename T, std::size_t N>
@@ -41,6 +160,16 @@ namespace monopoly {
 		std::array<T, railway_count>,
 		std::array<T, utility_count>>;
 
+	// Number of rounds tracked individually by round series statistics.
+	inline constexpr unsigned round_series_length = 128;
+
+	[[nodiscard]]
+	constexpr unsigned round_series_index(unsigned const round) noexcept {
+		return round < round_series_length ? round : round_series_length;
+	}
+
+	using round_series_int_count = counter_array<int_count, round_series_length + 1>;
+
 	using per_property_int_count = per_propertytype_data<
 		counter_array<int_count, street_count>,
 		counter_array<int_count, railway_count>,
@@ -64,15 +193,8 @@ namespace monopoly {
 			if (value >= true_max) {
 				return bin_count - 1;
 			}
-			unsigned bin = 0;
-			unsigned long long bin_upper_bound = 2;
-			while (true) {
-				if (value < bin_upper_bound) {
-					return bin;
-				}
-				++bin;
-				bin_upper_bound *= 2;
-			}
+			// 0 and 1 share the first bin.
+			return std::bit_width(value | 1) - 1;
 		}
 
 		// Returns exclusive upper bound of each bin.
@@ -107,6 +229,159 @@ namespace monopoly {
 	};
 
 
+	// Histogram with bins of constant relative width (HDR style).
+	// Values below 2^PrecisionBits each have their own bin. Above that, each power of 2 range is split into
+	// 2^PrecisionBits equal bins, so a bin's width is at most 2^-PrecisionBits of its values.
+	// Values above Max share the final bin.
+	template<unsigned long long Max, unsigned PrecisionBits, typename Count = int_count>
+		requires (PrecisionBits < 32 && Max >= (1ull << PrecisionBits))
+	struct log_linear_histogram {
+		static constexpr unsigned long long sub_bin_count = 1ull << PrecisionBits;
+
+		[[nodiscard]]
+		static constexpr unsigned compute_bin_unclamped(unsigned long long const value) noexcept {
+			if (value < sub_bin_count) {
+				return static_cast<unsigned>(value);
+			}
+			// value >> shift is in [sub_bin_count, 2 * sub_bin_count), so bins follow on from the linear range.
+			auto const shift = static_cast<unsigned>(std::bit_width(value)) - 1 - PrecisionBits;
+			return static_cast<unsigned>(shift * sub_bin_count + (value >> shift));
+		}
+
+		static constexpr unsigned bin_count = compute_bin_unclamped(Max) + 2;
+
+		counter_array<Count, bin_count> bins;
+
+		constexpr void add(unsigned long long const value) noexcept {
+			++bins[compute_bin(value)];
+		}
+
+		[[nodiscard]]
+		static constexpr unsigned compute_bin(unsigned long long const value) noexcept {
+			return value > Max ? bin_count - 1 : compute_bin_unclamped(value);
+		}
+
+		// Inclusive lower bound of the values in a bin.
+		[[nodiscard]]
+		static constexpr unsigned long long bin_lower_bound(unsigned const bin) noexcept {
+			if (bin == bin_count - 1) {
+				return Max + 1;
+			}
+			if (bin < sub_bin_count) {
+				return bin;
+			}
+			auto const shift = bin / sub_bin_count - 1;
+			return (bin - shift * sub_bin_count) << shift;
+		}
+
+		// Calls func with arguments of (bin_lower, bin_upper, bin_value), as log2_histogram does.
+		// bin_upper is exclusive, and is 0 for the last bin, representing infinity.
+		void enumerate_bins(auto func) const {
+			for (unsigned i = 0; i < bin_count - 1; ++i) {
+				func(bin_lower_bound(i), bin_lower_bound(i + 1), bins[i]);
+			}
+			func(bin_lower_bound(bin_count - 1), 0ull, bins.back());
+		}
+
+		[[nodiscard]]
+		int_count count() const noexcept {
+			int_count total = 0;
+			for (auto const value : bins) {
+				total += value;
+			}
+			return total;
+		}
+
+		// Largest value in the bin containing the q'th quantile (0 <= q <= 1), so the result is an upper bound accurate
+		// to within the bin width. Returns Max + 1 if the quantile is above Max, and 0 if the histogram is empty.
+		[[nodiscard]]
+		unsigned long long value_at_quantile(double const q) const noexcept {
+			auto const total = count();
+			if (total == 0) {
+				return 0;
+			}
+			// Rank of the sample, from 1.
+			auto const rank = std::max<int_count>(1, static_cast<int_count>(std::ceil(q * static_cast<double>(total))));
+			int_count cumulative = 0;
+			for (unsigned i = 0; i < bin_count - 1; ++i) {
+				cumulative += bins[i];
+				if (cumulative >= rank) {
+					return bin_lower_bound(i + 1) - 1;
+				}
+			}
+			return Max + 1;
+		}
+
+		template<typename OtherCount>
+		log_linear_histogram& operator+=(log_linear_histogram<Max, PrecisionBits, OtherCount> const& other) {
+			for (unsigned i = 0; i < bin_count; ++i) {
+				bins[i] += other.bins[i];
+			}
+			return *this;
+		}
+	};
+
+	// For amounts of cash: $0 to $65536 with bins at most ~3% wide.
+	using cash_histogram = log_linear_histogram<1ull << 16, 5>;
+
+
+	// Running count, mean, variance and range of a per-game quantity.
+	// Updated with Welford's algorithm, merged with Chan et al.'s pairwise formula, so partial results from
+	// different threads can be combined without keeping the samples.
+	struct moment_accumulator {
+		int_count count{};
+		float_count mean{};
+		// Sum of squared deviations from the mean.
+		float_count m2{};
+		// Infinite while count is 0.
+		float_count min = std::numeric_limits<float_count>::infinity();
+		float_count max = -std::numeric_limits<float_count>::infinity();
+
+		constexpr void add(double const value) noexcept {
+			++count;
+			auto const delta = value - mean;
+			mean += delta / static_cast<double>(count);
+			m2 += delta * (value - mean);
+			min = value < min ? value : min;
+			max = value > max ? value : max;
+		}
+
+		// Unbiased sample variance.
+		[[nodiscard]]
+		constexpr double variance() const noexcept {
+			return count >= 2 ? m2 / static_cast<double>(count - 1) : 0.0;
+		}
+
+		// Standard error of the mean. Infinite if there are too few samples to estimate the variance.
+		[[nodiscard]]
+		double standard_error() const noexcept {
+			if (count < 2) {
+				return std::numeric_limits<double>::infinity();
+			}
+			return std::sqrt(variance() / static_cast<double>(count));
+		}
+
+		moment_accumulator& operator+=(moment_accumulator const& other) {
+			if (other.count == 0) {
+				return *this;
+			}
+			if (count == 0) {
+				*this = other;
+				return *this;
+			}
+			auto const total = count + other.count;
+			auto const delta = other.mean - mean;
+			auto const other_weight = static_cast<double>(other.count) / static_cast<double>(total);
+			mean += delta * other_weight;
+			m2 += other.m2 + delta * delta * static_cast<double>(count) * other_weight;
+			count = total;
+			min = other.min < min ? other.min : min;
+			max = other.max > max ? other.max : max;
+			return *this;
+		}
+	};
+
+
 	struct stat_counters_t {
 		// Statistics are not guaranteed to be updated until the end of each game.
 
@@ -122,11 +397,19 @@ namespace monopoly {
 		// Histogram of game lengths.
 		log2_histogram<100> game_length_histogram;
 
+		// Distribution of game lengths, in rounds.
+		moment_accumulator game_length_moments;
+
 		// Number of turns played, for each player.
 		// This includes all turns (including in jail) when the player is not bankrupt.
 		// Extra turns from rolling doubles count multiple times.
 		per_player_int_count turns_played{};
 
+		// Sum of each hardware counter (see hardware_counters.hpp) over the threads it was available on, and the
+		// number of turns played while it was counting.
+		counter_array<int_count, hardware_counter_count> hardware_counter_values{};
+		counter_array<int_count, hardware_counter_count> hardware_counter_turns{};
+
 		// Number of times passed Go and collected Go salary, for each player.
 		per_player_int_count go_passes{};
 
@@ -134,9 +417,47 @@ namespace monopoly {
 		// 0 = first place, to player_count-1 = last place
 		per_player_int_count player_rank{};
 
+		// Distribution of end game ranks for each player.
+		per_player_counter<moment_accumulator> player_rank_moments{};
+
 		// Sum of end game net worths for each player.
 		per_player_int_count final_net_worth{};
 
+		// Final net worth, for the spread between games.
+		per_player_counter<moment_accumulator> final_net_worth_moments{};
+
+		// Distribution of end game net worths for each player.
+		per_player_counter<cash_histogram> final_net_worth_histogram{};
+
+		// Distribution of the cash a player could raise (after selling assets) for the payment which bankrupted them.
+		cash_histogram bankruptcy_cash_histogram;
+
+		// Distribution of the size of individual rent payments.
+		log_linear_histogram<max_single_rent, 5> rent_payment_histogram;
+
+		// Distribution of winning bids in auctions of unowned properties, over all properties.
+		cash_histogram unowned_auction_price_histogram;
+
+		// Distribution of the number of turns in a game, over all players.
+		quantile_sketch<std::uint32_t> turns_per_game_sketch;
+
+		// Distribution of the total rent paid in a game, over all players.
+		quantile_sketch<std::uint32_t> rent_per_game_sketch;
+
+		// State of the game after each number of rounds, summed over the games which lasted at least that long.
+		// Index r is after r rounds. The final index is shared by all rounds from round_series_length on.
+		round_series_int_count round_series_games{};
+		per_player_counter<round_series_int_count> round_series_cash{};
+		per_player_counter<round_series_int_count> round_series_net_worth{};
+		// Number of properties owned.
+		per_player_counter<round_series_int_count> round_series_property_count{};
+		// Number of games in which the player is bankrupt.
+		per_player_counter<round_series_int_count> round_series_bankrupt_count{};
+
+		// Number of games with each final rank, for each player and each combination of the player's
+		// cohort_feature_t bits, i.e. cohort_rank_counts[player][mask][rank].
+		per_player_counter<counter_array<per_player_int_count, cohort_mask_count>> cohort_rank_counts{};
+
 		// Property rent paid, for each player.
 		per_player_int_count rent_paid_amount{};
 
@@ -211,50 +532,176 @@ namespace monopoly {
 		// Cash received from selling properties.
 		per_player_int_count property_sell_income{};
 
-		stat_counters_t& operator+=(stat_counters_t const& other) {
-			auto const apply = [this, &other](auto const member) {
-				this->*member += (&other)->*member;
-			};
+		// Each player's amounts of the cash flows above in a game, for the spread between games.
+		per_player_counter<moment_accumulator> go_salary_moments{};
+		per_player_counter<moment_accumulator> rent_paid_moments{};
+		per_player_counter<moment_accumulator> rent_received_moments{};
+		per_player_counter<moment_accumulator> cash_award_card_amount_moments{};
+		per_player_counter<moment_accumulator> per_player_cash_fee_card_receive_amount_moments{};
+		per_player_counter<moment_accumulator> per_player_cash_award_card_payment_amount_moments{};
+		per_player_counter<moment_accumulator> cash_fee_card_amount_moments{};
+		per_player_counter<moment_accumulator> property_purchase_cost_moments{};
+		per_player_counter<moment_accumulator> property_sell_income_moments{};
+
+		// Merges counters from other games (e.g. from another thread). Generated from stat_counter_registry.
+		stat_counters_t& operator+=(stat_counters_t const& other);
+	};
 
-			// TODO: there must be an easier way to do this
-			using T = stat_counters_t;
-			apply(&T::simulation_time_seconds);
-			apply(&T::games);
-			apply(&T::rounds);
-			apply(&T::game_length_histogram);
-			apply(&T::turns_played);
-			apply(&T::go_passes);
-			apply(&T::player_rank);
-			apply(&T::final_net_worth);
-			apply(&T::rent_paid_amount);
-			apply(&T::rent_paid_count);
-			apply(&T::rent_received_amount);
-			apply(&T::rent_received_count);
-			apply(&T::board_space_counts);
-			apply(&T::sent_to_jail_count);
-			apply(&T::turns_in_jail);
-			apply(&T::jail_fee_paid_count);
-			apply(&T::cards_drawn);
-			apply(&T::cash_award_card_amount);
-			apply(&T::cash_award_cards_drawn);
-			apply(&T::per_player_cash_fee_card_receive_amount);
-			apply(&T::per_player_cash_fee_card_receive_count);
-			apply(&T::per_player_cash_award_card_payment_amount);
-			apply(&T::per_player_cash_award_card_payment_count);
-			apply(&T::cash_fee_card_amount);
-			apply(&T::cash_fee_cards_drawn);
-			apply(&T::property_purchased_at_least_once);
-			apply(&T::property_first_purchase_round);
-			apply(&T::property_unowned_auction_price);
-			apply(&T::property_unowned_auction_count);
-			apply(&T::unowned_property_auctions_won);
-			apply(&T::property_purchase_costs);
-			apply(&T::property_sell_income);
 
-			return *this;
-		}
+	// Describes one member of stat_counters_t.
+	// The shape of the counter is given by the member's type, and counters are reduced with the type's operator+=
+	// (element-wise sums for counts, pairwise merges for moments).
+	template<typename T>
+	struct stat_counter_info_t {
+		using counter_type = T;
+
+		std::string_view name;
+		stat_group_t group;
+		T stat_counters_t::* member;
+	};
+
+	// Every counter in stat_counters_t. Merging, serialisation and export are all generated from this, so a new
+	// counter only needs to be added here. The order is the serialisation order, so changing it (or adding
+	// counters) requires incrementing stat_counters_file_version.
+	inline constexpr std::tuple stat_counter_registry{
+		stat_counter_info_t{"simulation_time_seconds", stat_group_t::basic, &stat_counters_t::simulation_time_seconds},
+		stat_counter_info_t{"games", stat_group_t::basic, &stat_counters_t::games},
+		stat_counter_info_t{"rounds", stat_group_t::basic, &stat_counters_t::rounds},
+		stat_counter_info_t{"game_length_histogram", stat_group_t::basic, &stat_counters_t::game_length_histogram},
+		stat_counter_info_t{"game_length_moments", stat_group_t::basic, &stat_counters_t::game_length_moments},
+		stat_counter_info_t{"turns_played", stat_group_t::basic, &stat_counters_t::turns_played},
+		stat_counter_info_t{"hardware_counter_values", stat_group_t::basic, &stat_counters_t::hardware_counter_values},
+		stat_counter_info_t{"hardware_counter_turns", stat_group_t::basic, &stat_counters_t::hardware_counter_turns},
+		stat_counter_info_t{"go_passes", stat_group_t::movement, &stat_counters_t::go_passes},
+		stat_counter_info_t{"player_rank", stat_group_t::endgame, &stat_counters_t::player_rank},
+		stat_counter_info_t{"player_rank_moments", stat_group_t::endgame, &stat_counters_t::player_rank_moments},
+		stat_counter_info_t{"final_net_worth", stat_group_t::endgame, &stat_counters_t::final_net_worth},
+		stat_counter_info_t{"final_net_worth_moments", stat_group_t::endgame,
+			&stat_counters_t::final_net_worth_moments},
+		stat_counter_info_t{"final_net_worth_histogram", stat_group_t::endgame,
+			&stat_counters_t::final_net_worth_histogram},
+		stat_counter_info_t{"bankruptcy_cash_histogram", stat_group_t::endgame,
+			&stat_counters_t::bankruptcy_cash_histogram},
+		stat_counter_info_t{"rent_payment_histogram", stat_group_t::cash_flow,
+			&stat_counters_t::rent_payment_histogram},
+		stat_counter_info_t{"unowned_auction_price_histogram", stat_group_t::auctions,
+			&stat_counters_t::unowned_auction_price_histogram},
+		stat_counter_info_t{"turns_per_game_sketch", stat_group_t::basic, &stat_counters_t::turns_per_game_sketch},
+		stat_counter_info_t{"rent_per_game_sketch", stat_group_t::cash_flow, &stat_counters_t::rent_per_game_sketch},
+		stat_counter_info_t{"round_series_games", stat_group_t::round_series, &stat_counters_t::round_series_games},
+		stat_counter_info_t{"round_series_cash", stat_group_t::round_series, &stat_counters_t::round_series_cash},
+		stat_counter_info_t{"round_series_net_worth", stat_group_t::round_series,
+			&stat_counters_t::round_series_net_worth},
+		stat_counter_info_t{"round_series_property_count", stat_group_t::round_series,
+			&stat_counters_t::round_series_property_count},
+		stat_counter_info_t{"round_series_bankrupt_count", stat_group_t::round_series,
+			&stat_counters_t::round_series_bankrupt_count},
+		stat_counter_info_t{"cohort_rank_counts", stat_group_t::cohorts, &stat_counters_t::cohort_rank_counts},
+		stat_counter_info_t{"rent_paid_amount", stat_group_t::cash_flow, &stat_counters_t::rent_paid_amount},
+		stat_counter_info_t{"rent_paid_count", stat_group_t::cash_flow, &stat_counters_t::rent_paid_count},
+		stat_counter_info_t{"rent_received_amount", stat_group_t::cash_flow, &stat_counters_t::rent_received_amount},
+		stat_counter_info_t{"rent_received_count", stat_group_t::cash_flow, &stat_counters_t::rent_received_count},
+		stat_counter_info_t{"board_space_counts", stat_group_t::movement, &stat_counters_t::board_space_counts},
+		stat_counter_info_t{"sent_to_jail_count", stat_group_t::movement, &stat_counters_t::sent_to_jail_count},
+		stat_counter_info_t{"turns_in_jail", stat_group_t::movement, &stat_counters_t::turns_in_jail},
+		stat_counter_info_t{"jail_fee_paid_count", stat_group_t::cash_flow, &stat_counters_t::jail_fee_paid_count},
+		stat_counter_info_t{"cards_drawn", stat_group_t::cards, &stat_counters_t::cards_drawn},
+		stat_counter_info_t{"cash_award_card_amount", stat_group_t::cards, &stat_counters_t::cash_award_card_amount},
+		stat_counter_info_t{"cash_award_cards_drawn", stat_group_t::cards, &stat_counters_t::cash_award_cards_drawn},
+		stat_counter_info_t{"per_player_cash_fee_card_receive_amount", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_fee_card_receive_amount},
+		stat_counter_info_t{"per_player_cash_fee_card_receive_count", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_fee_card_receive_count},
+		stat_counter_info_t{"per_player_cash_award_card_payment_amount", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_award_card_payment_amount},
+		stat_counter_info_t{"per_player_cash_award_card_payment_count", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_award_card_payment_count},
+		stat_counter_info_t{"cash_fee_card_amount", stat_group_t::cards, &stat_counters_t::cash_fee_card_amount},
+		stat_counter_info_t{"cash_fee_cards_drawn", stat_group_t::cards, &stat_counters_t::cash_fee_cards_drawn},
+		stat_counter_info_t{"property_purchased_at_least_once", stat_group_t::property,
+			&stat_counters_t::property_purchased_at_least_once},
+		stat_counter_info_t{"property_first_purchase_round", stat_group_t::property,
+			&stat_counters_t::property_first_purchase_round},
+		stat_counter_info_t{"property_unowned_auction_price", stat_group_t::auctions,
+			&stat_counters_t::property_unowned_auction_price},
+		stat_counter_info_t{"property_unowned_auction_count", stat_group_t::auctions,
+			&stat_counters_t::property_unowned_auction_count},
+		stat_counter_info_t{"unowned_property_auctions_won", stat_group_t::auctions,
+			&stat_counters_t::unowned_property_auctions_won},
+		stat_counter_info_t{"property_purchase_costs", stat_group_t::property,
+			&stat_counters_t::property_purchase_costs},
+		stat_counter_info_t{"property_sell_income", stat_group_t::property, &stat_counters_t::property_sell_income},
+		stat_counter_info_t{"go_salary_moments", stat_group_t::movement, &stat_counters_t::go_salary_moments},
+		stat_counter_info_t{"rent_paid_moments", stat_group_t::cash_flow, &stat_counters_t::rent_paid_moments},
+		stat_counter_info_t{"rent_received_moments", stat_group_t::cash_flow, &stat_counters_t::rent_received_moments},
+		stat_counter_info_t{"cash_award_card_amount_moments", stat_group_t::cards,
+			&stat_counters_t::cash_award_card_amount_moments},
+		stat_counter_info_t{"per_player_cash_fee_card_receive_amount_moments", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_fee_card_receive_amount_moments},
+		stat_counter_info_t{"per_player_cash_award_card_payment_amount_moments", stat_group_t::cards,
+			&stat_counters_t::per_player_cash_award_card_payment_amount_moments},
+		stat_counter_info_t{"cash_fee_card_amount_moments", stat_group_t::cards,
+			&stat_counters_t::cash_fee_card_amount_moments},
+		stat_counter_info_t{"property_purchase_cost_moments", stat_group_t::property,
+			&stat_counters_t::property_purchase_cost_moments},
+		stat_counter_info_t{"property_sell_income_moments", stat_group_t::property,
+			&stat_counters_t::property_sell_income_moments}
 	};
 
+	namespace statistics_counters_detail {
+
+		template<typename... Infos>
+		[[nodiscard]]
+		constexpr std::size_t registered_size(std::tuple<Infos...> const&) noexcept {
+			return (sizeof(typename Infos::counter_type) + ... + 0);
+		}
+
+		template<typename T, typename U>
+		[[nodiscard]]
+		constexpr bool is_same_member(T stat_counters_t::* const lhs, U stat_counters_t::* const rhs) noexcept {
+			if constexpr (std::is_same_v<T, U>) {
+				return lhs == rhs;
+			}
+			else {
+				return false;
+			}
+		}
+
+		// Whether no member is registered more than once.
+		template<typename... Infos>
+		[[nodiscard]]
+		constexpr bool registered_members_distinct(std::tuple<Infos...> const& registry) noexcept {
+			return std::apply([](auto const&... infos) {
+				auto const occurrences = [&infos...](auto const& info) {
+					return (static_cast<unsigned>(is_same_member(info.member, infos.member)) + ... + 0u);
+				};
+				return ((occurrences(infos) == 1) && ...);
+			}, registry);
+		}
+
+	}
+
+	// Every member must be registered, otherwise it would silently not be merged, saved or exported.
+	// With no member registered twice, the sizes only add up if every member is registered. Members are all
+	// multiples of 8 bytes, so stat_counters_t has no padding to account for.
+	static_assert(statistics_counters_detail::registered_members_distinct(stat_counter_registry),
+		"stat_counter_registry must not list a member of stat_counters_t more than once");
+	static_assert(statistics_counters_detail::registered_size(stat_counter_registry) == sizeof(stat_counters_t),
+		"stat_counter_registry must list every member of stat_counters_t");
+
+	// Calls func(info) with the stat_counter_info_t of every counter, in registry order.
+	constexpr void for_each_stat_counter(auto&& func) {
+		std::apply([&func](auto const&... infos) { (func(infos), ...); }, stat_counter_registry);
+	}
+
+	inline stat_counters_t& stat_counters_t::operator+=(stat_counters_t const& other) {
+		// Disabled groups are merged too, since the counters may have been read from a file written by another build.
+		for_each_stat_counter([this, &other](auto const& info) {
+			this->*info.member += other.*info.member;
+		});
+		return *this;
+	}
+
 	inline stat_counters_t operator+(stat_counters_t lhs, stat_counters_t const& rhs) {
 		lhs += rhs;
 		return lhs;
@@ -263,6 +710,158 @@ namespace monopoly {
 	thread_local inline stat_counters_t stat_counters{};
 
 
+	// The most frequently updated counters, accumulated for one game in game_state_t::stats and added to
+	// stat_counters by flush_game_stats() at the end of the game (and periodically during very long games).
+	// Kept small, with narrow types, so updates during the game are cheap stores near the rest of the game state
+	// instead of thread local lookups into the large stat_counters_t. To rule out overflow, games must be flushed at
+	// least every flush_interval_rounds rounds.
+	struct game_stat_counters_t {
+		using count = std::uint16_t;
+		using amount = std::uint32_t;
+		using per_player_count = std::array<count, player_count>;
+		using per_player_amount = std::array<amount, player_count>;
+
+		// See the same members of stat_counters_t.
+		std::array<std::array<count, board_space_count + 1>, player_count> board_space_counts{};
+		per_player_count turns_played{};
+		per_player_count go_passes{};
+		per_player_count sent_to_jail_count{};
+		per_player_count turns_in_jail{};
+		per_player_count jail_fee_paid_count{};
+		per_player_count cards_drawn{};
+		per_player_count rent_paid_count{};
+		per_player_count rent_received_count{};
+		per_player_amount rent_paid_amount{};
+		per_player_amount rent_received_amount{};
+		// Bins count rent payments by all players, so are bounded by max_count_increase_per_round too.
+		log_linear_histogram<max_single_rent, 5, count> rent_payment_histogram;
+
+		// Whole-game values, which aren't reset by flushes.
+		struct game_totals_t {
+			// Over all players, accumulated by each flush.
+			std::uint64_t game_turns = 0;
+			std::uint64_t game_rent_amount = 0;
+			// Accumulated by each flush.
+			std::array<std::uint32_t, player_count> sent_to_jail_count{};
+			// Features found so far, see cohort_features.hpp.
+			std::array<cohort_mask_t, player_count> cohort_masks{};
+			// Bit per player, set once the player has bought a property from the bank.
+			std::uint8_t players_purchased = 0;
+			// Largest single rent payment (with the cash flow group).
+			std::uint32_t max_rent_payment = 0;
+			// Largest amount by which each player's net worth was behind the leader's at the start of a round (with
+			// the round series group).
+			std::array<unsigned long long, player_count> max_net_worth_deficit{};
+			// Each player's cash flows over the game (with the group recording each), see the *_moments members of
+			// stat_counters_t. Go passes and rent are accumulated by each flush, the others as they happen.
+			std::array<std::uint64_t, player_count> go_passes{};
+			std::array<std::uint64_t, player_count> rent_paid_amount{};
+			std::array<std::uint64_t, player_count> rent_received_amount{};
+			std::array<std::uint64_t, player_count> cash_award_card_amount{};
+			std::array<std::uint64_t, player_count> per_player_cash_fee_card_receive_amount{};
+			std::array<std::uint64_t, player_count> per_player_cash_award_card_payment_amount{};
+			std::array<std::uint64_t, player_count> cash_fee_card_amount{};
+			std::array<std::uint64_t, player_count> property_purchase_costs{};
+			std::array<std::uint64_t, player_count> property_sell_income{};
+		};
+		game_totals_t totals;
+
+		// Bound on how much any count can increase in one round.
+		// Each player has at most consecutive_doubles_jail_threshold turns per round. A turn moves the player at most
+		// 4 times (leaving jail, the dice roll, a Chance card moving them to Community Chest, then a Community Chest
+		// card), and each move triggers at most one of each event (max_turns_in_jail for turns in jail).
+		// A player can receive rent from every player's turns, hence the factor of player_count.
+		static constexpr unsigned max_increments_per_turn = 8;
+		static_assert(max_turns_in_jail <= max_increments_per_turn);
+		static constexpr unsigned max_count_increase_per_round =
+			player_count * consecutive_doubles_jail_threshold * max_increments_per_turn;
+		static constexpr unsigned long long max_amount_increase_per_round =
+			static_cast<unsigned long long>(max_count_increase_per_round) * max_single_rent;
+
+		static constexpr unsigned flush_interval_rounds = 256;
+		static_assert(static_cast<unsigned long long>(flush_interval_rounds) * max_count_increase_per_round
+			<= std::numeric_limits<count>::max());
+		static_assert(flush_interval_rounds * max_amount_increase_per_round <= std::numeric_limits<amount>::max());
+	};
+
+	// Widens the game's counters into the thread's totals and resets them.
+	inline void flush_game_stats(game_stat_counters_t& game_stats) {
+		// Turns are counted even if statistics are disabled (see do_single_turn()).
+		for (auto const player : players) {
+			stat_counters.turns_played[player] += game_stats.turns_played[player];
+		}
+
+		if constexpr (record_stats) {
+			auto totals = game_stats.totals;
+			for (auto const player : players) {
+				totals.game_turns += game_stats.turns_played[player];
+				totals.game_rent_amount += game_stats.rent_paid_amount[player];
+				totals.sent_to_jail_count[player] += game_stats.sent_to_jail_count[player];
+				if constexpr (record_stat_group<stat_group_t::movement>) {
+					for (std::size_t space = 0; space < board_space_count + 1; ++space) {
+						stat_counters.board_space_counts[player][space] +=
+							game_stats.board_space_counts[player][space];
+					}
+					stat_counters.go_passes[player] += game_stats.go_passes[player];
+					totals.go_passes[player] += game_stats.go_passes[player];
+					stat_counters.sent_to_jail_count[player] += game_stats.sent_to_jail_count[player];
+					stat_counters.turns_in_jail[player] += game_stats.turns_in_jail[player];
+				}
+				if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+					stat_counters.jail_fee_paid_count[player] += game_stats.jail_fee_paid_count[player];
+					stat_counters.rent_paid_count[player] += game_stats.rent_paid_count[player];
+					stat_counters.rent_received_count[player] += game_stats.rent_received_count[player];
+					stat_counters.rent_paid_amount[player] += game_stats.rent_paid_amount[player];
+					stat_counters.rent_received_amount[player] += game_stats.rent_received_amount[player];
+					totals.rent_paid_amount[player] += game_stats.rent_paid_amount[player];
+					totals.rent_received_amount[player] += game_stats.rent_received_amount[player];
+				}
+				if constexpr (record_stat_group<stat_group_t::cards>) {
+					stat_counters.cards_drawn[player] += game_stats.cards_drawn[player];
+				}
+			}
+			if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+				stat_counters.rent_payment_histogram += game_stats.rent_payment_histogram;
+			}
+			game_stats = game_stat_counters_t{};
+			game_stats.totals = totals;
+		}
+		else {
+			game_stats.turns_played = {};
+		}
+	}
+
+
+	// Adds each player's cash flows over the finished game to the spread between games.
+	inline void record_game_cash_flows(game_stat_counters_t::game_totals_t const& totals) {
+		for (auto const player : players) {
+			auto const add = [player](per_player_counter<moment_accumulator>& moments,
+					std::array<std::uint64_t, player_count> const& amounts) {
+				moments[player].add(static_cast<double>(amounts[player]));
+			};
+			if constexpr (record_stat_group<stat_group_t::movement>) {
+				stat_counters.go_salary_moments[player].add(static_cast<double>(totals.go_passes[player] * go_salary));
+			}
+			if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+				add(stat_counters.rent_paid_moments, totals.rent_paid_amount);
+				add(stat_counters.rent_received_moments, totals.rent_received_amount);
+			}
+			if constexpr (record_stat_group<stat_group_t::cards>) {
+				add(stat_counters.cash_award_card_amount_moments, totals.cash_award_card_amount);
+				add(stat_counters.per_player_cash_fee_card_receive_amount_moments,
+					totals.per_player_cash_fee_card_receive_amount);
+				add(stat_counters.per_player_cash_award_card_payment_amount_moments,
+					totals.per_player_cash_award_card_payment_amount);
+				add(stat_counters.cash_fee_card_amount_moments, totals.cash_fee_card_amount);
+			}
+			if constexpr (record_stat_group<stat_group_t::property>) {
+				add(stat_counters.property_purchase_cost_moments, totals.property_purchase_costs);
+				add(stat_counters.property_sell_income_moments, totals.property_sell_income);
+			}
+		}
+	}
+
+
 	// Per-game state needed for tracking statistics.
 	// Reset at the start of each game.
 	struct stat_helper_state_t {
@@ -8,9 +8,11 @@
 #include "card_deck_operations.hpp"
 #include "cash.hpp"
 #include "common_types.hpp"
+#include "event_trace.hpp"
 #include "game_state.hpp"
 #include "gameplay_constants.hpp"
 #include "movement.hpp"
+#include "phase_profiler.hpp"
 #include "player_strategy.hpp"
 #include "position.hpp"
 #include "random.hpp"
@@ -27,7 +29,12 @@ namespace monopoly {
 		assert(!player_state.in_jail());
 		assert(!player_state.is_bankrupt());
 
-		auto const [roll, is_double] = random.double_dice_roll();
+		auto const [roll, is_double] = profile_phase<profile_phase_t::dice>([&random] {
+			return random.double_dice_roll();
+		});
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->dice(game_state, player, roll, is_double);
+		}
 
 		if (is_double) {
 			auto const consecutive_doubles = player_state.consecutive_doubles + 1;
@@ -45,7 +52,9 @@ namespace monopoly {
 		}
 
 		game_state.turn.movement_roll = roll;
-		advance_by_spaces(game_state, player, roll);
+		profile_phase<profile_phase_t::movement>([&game_state, player, roll] {
+			advance_by_spaces(game_state, player, roll);
+		});
 		on_board_space(game_state, strategies, random, player);
 
 		return is_double && !player_state.in_jail() && !player_state.is_bankrupt();
@@ -57,6 +66,7 @@ namespace monopoly {
 		auto& player_state = game_state.players[player];
 		assert(player_state.in_jail());
 		assert(!player_state.is_bankrupt());
+		scoped_phase_timer const timer{profile_phase_t::jail};
 
 		// The rules about getting out of jail seem to be ambiguous or not well agreed upon.
 		// What is implemented here is as follows.
@@ -78,7 +88,12 @@ namespace monopoly {
 			});
 
 		// No matter what happens, the player gets to roll. Either to try to get out of jail, or to move normally.
-		auto const roll = random.double_dice_roll();
+		auto const roll = profile_phase<profile_phase_t::dice>([&random] {
+			return random.double_dice_roll();
+		});
+		if (game_state.event_trace != nullptr) [[unlikely]] {
+			game_state.event_trace->dice(game_state, player, roll.roll, roll.is_double);
+		}
 
 		auto const use_get_out_of_jail_free_card = [&game_state, player]<card_type_t C>() {
 			assert(game_state.get_out_of_jail_free_ownership.is_owner(player, C));
@@ -88,8 +103,8 @@ namespace monopoly {
 		switch (jail_action) {
 		case in_jail_action_t::pay_fine: {
 			player_pay_bank_from_hand(game_state, player, jail_release_cost);
-			if constexpr (record_stats) {
-				stat_counters.jail_fee_paid_count[player]++;
+			if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+				game_state.stats.jail_fee_paid_count[player]++;
 			}
 			break;
 		}
@@ -109,14 +124,14 @@ namespace monopoly {
 				if (new_position >= 0) {
 					// Time in jail is up, forced to pay to be released.
 					player_pay_bank(game_state, strategies, random, player, jail_release_cost);
-					if constexpr (record_stats) {
-						stat_counters.jail_fee_paid_count[player]++;
+					if constexpr (record_stat_group<stat_group_t::cash_flow>) {
+						game_state.stats.jail_fee_paid_count[player]++;
 					}
 
 					// May have become bankrupt from paying get out of jail fee.
 					if (player_state.is_bankrupt()) {
-						if constexpr (record_stats) {
-							stat_counters.turns_in_jail[player] += max_turns_in_jail;
+						if constexpr (record_stat_group<stat_group_t::movement>) {
+							game_state.stats.turns_in_jail[player] += max_turns_in_jail;
 						}
 						// Turn ends.
 						return false;
@@ -139,12 +154,12 @@ namespace monopoly {
 
 		// If we get here then player is being released from jail.
 
-		if constexpr (record_stats) {
+		if constexpr (record_stat_group<stat_group_t::movement>) {
 			assert(std::cmp_greater_equal(player_state.position, -static_cast<long>(max_turns_in_jail)));
 			assert(std::cmp_less(player_state.position, 0));
 			auto const turns_in_jail = player_state.position + static_cast<long>(max_turns_in_jail) + 1;
 			assert(turns_in_jail >= 1);
-			stat_counters.turns_in_jail[player] += turns_in_jail;
+			game_state.stats.turns_in_jail[player] += turns_in_jail;
 		}
 
 		// Need to set position back to a normal board space first, since movement functions don't deal with moving
@@ -161,7 +176,9 @@ namespace monopoly {
 
 		// It's impossible to pass Go from jail.
 		assert(roll.roll <= 12);
-		advance_by_spaces_no_go(game_state, player, roll.roll);
+		profile_phase<profile_phase_t::movement>([&game_state, player, &roll] {
+			advance_by_spaces_no_go(game_state, player, roll.roll);
+		});
 		on_board_space(game_state, strategies, random, player);
 
 		// Don't get another turn if tried to roll doubles.
@@ -175,7 +192,8 @@ namespace monopoly {
 			unsigned const player) {
 		auto const& player_state = game_state.players[player];
 		assert(!player_state.is_bankrupt());
-		
+		scoped_phase_timer const timer{profile_phase_t::turn};
+
 		game_state.turn = turn_state_t{};
 #ifndef NDEBUG
 		game_state.turn.player = player;
@@ -197,9 +215,8 @@ namespace monopoly {
 		// Sanity check, player's position should always change each turn, unless they are bankrupt.
 		assert(game_state.turn.position_changed || player_state.is_bankrupt());
 
-		if constexpr (record_stats) {
-			stat_counters.turns_played[player]++;
-		}
+		// Counted even if statistics are disabled, since simulation speed is measured in turns.
+		game_state.stats.turns_played[player]++;
 
 		return extra_turn;
 	}
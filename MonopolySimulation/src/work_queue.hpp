@@ -0,0 +1,287 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stop_token>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "game_range.hpp"
+#include "stat_counters_io.hpp"
+#include "statistics_counters.hpp"
+
+
+// Coordinator-free queue of game ranges shared between worker processes through a directory, e.g. on a network
+// filesystem. Relies only on rename within a directory tree being atomic.
+//
+// Layout:
+//   experiment.txt       Base seed, max rounds and the games of the whole experiment, shared by all ranges.
+//   pending/FIRST_COUNT  Ranges not yet claimed.
+//   claimed/FIRST_COUNT  Ranges being run. Modification time is refreshed by the worker as a heartbeat.
+//   results/FIRST_COUNT  Counters files of completed ranges.
+//
+// A worker claims a range by renaming it from pending/ to claimed/. Only one rename can succeed.
+// Claims whose heartbeat stops (e.g. the worker was killed) are renamed back to pending/ by any other worker.
+// Since games are seeded by index, a range that happens to be run twice produces an identical results file.
+namespace monopoly {
+
+	struct work_queue_config_t {
+		std::uint64_t base_seed = 0;
+		std::uint32_t max_rounds = 0;		// 0 = no limit.
+		// All games of the experiment, which the ranges cover.
+		game_range_t games;
+	};
+
+	struct work_queue_status_t {
+		std::size_t pending = 0;
+		std::size_t claimed = 0;
+		std::size_t completed = 0;
+	};
+
+
+	[[nodiscard]]
+	inline std::string game_range_file_name(game_range_t const range) {
+		return std::to_string(range.first) + '_' + std::to_string(range.count);
+	}
+
+	[[nodiscard]]
+	inline std::optional<game_range_t> parse_game_range_file_name(std::string_view const name) {
+		auto const separator = name.find('_');
+		if (separator == std::string_view::npos) {
+			return std::nullopt;
+		}
+		game_range_t range;
+		auto const parse = [](std::string_view const str, std::uint64_t& value) {
+			auto const [end, error] = std::from_chars(str.data(), str.data() + str.size(), value);
+			return error == std::errc{} && end == str.data() + str.size();
+		};
+		if (!parse(name.substr(0, separator), range.first) || !parse(name.substr(separator + 1), range.count)
+				|| range.count == 0) {
+			return std::nullopt;
+		}
+		return range;
+	}
+
+
+	class work_queue_t {
+	public:
+		explicit work_queue_t(std::filesystem::path root) :
+			_root{std::move(root)}
+		{}
+
+		// Creates the queue directory, with the games split into ranges of at most range_games games.
+		// Return value indicates success. Fails if the queue already exists.
+		bool initialise(work_queue_config_t const& config, std::uint64_t const range_games) {
+			assert(range_games >= 1);
+			std::error_code error;
+			if (std::filesystem::exists(config_path(), error)) {
+				return false;
+			}
+			for (auto const& dir : {pending_dir(), claimed_dir(), results_dir()}) {
+				std::filesystem::create_directories(dir, error);
+				if (error) {
+					return false;
+				}
+			}
+
+			auto const& games = config.games;
+			for (auto first = games.first; first < games.end(); first += range_games) {
+				game_range_t const range{first, std::min(range_games, games.end() - first)};
+				std::ofstream file{pending_dir() / game_range_file_name(range)};
+				if (!file) {
+					return false;
+				}
+			}
+
+			// Written last, so workers can't start on a partially initialised queue.
+			auto const temp_path = unique_temp_path(config_path());
+			{
+				std::ofstream file{temp_path};
+				file << "seed " << config.base_seed << '\n' << "max_rounds " << config.max_rounds << '\n'
+					<< "games " << games.first << ' ' << games.count << '\n';
+				if (!file) {
+					return false;
+				}
+			}
+			std::filesystem::rename(temp_path, config_path(), error);
+			return !error;
+		}
+
+		[[nodiscard]]
+		std::optional<work_queue_config_t> read_config() const {
+			std::ifstream file{config_path()};
+			work_queue_config_t config;
+			std::string seed_key;
+			std::string max_rounds_key;
+			std::string games_key;
+			file >> seed_key >> config.base_seed >> max_rounds_key >> config.max_rounds
+				>> games_key >> config.games.first >> config.games.count;
+			if (!file || seed_key != "seed" || max_rounds_key != "max_rounds" || games_key != "games") {
+				return std::nullopt;
+			}
+			return config;
+		}
+
+		// Attempts to claim a pending range. Returns nullopt if there are no pending ranges left.
+		[[nodiscard]]
+		std::optional<game_range_t> claim() {
+			auto candidates = list_ranges(pending_dir());
+			// Start at a random position so concurrent workers don't all fight over the same range.
+			std::ranges::shuffle(candidates, _random);
+			for (auto const& range : candidates) {
+				auto const name = game_range_file_name(range);
+				std::error_code error;
+				std::filesystem::rename(pending_dir() / name, claimed_dir() / name, error);
+				if (!error) {
+					heartbeat(range);
+					return range;
+				}
+				// Another worker got it first.
+			}
+			return std::nullopt;
+		}
+
+		// Refreshes the claim so it isn't considered stale.
+		void heartbeat(game_range_t const range) const {
+			std::error_code error;
+			std::filesystem::last_write_time(claimed_dir() / game_range_file_name(range),
+				std::filesystem::file_time_type::clock::now(), error);
+		}
+
+		// Saves the results of a claimed range and releases the claim.
+		// Return value indicates success.
+		bool complete(game_range_t const range, work_queue_config_t const& config, stat_counters_t const& counters) {
+			auto const name = game_range_file_name(range);
+			stat_counters_file_info_t const info{config.base_seed, range.first, range.count, config.max_rounds};
+			if (!write_stat_counters_file(results_dir() / name, info, counters)) {
+				return false;
+			}
+			std::error_code error;
+			std::filesystem::remove(claimed_dir() / name, error);
+			return true;
+		}
+
+		// Moves claims without a heartbeat for longer than max_age back to pending.
+		// Returns the number of claims requeued.
+		std::size_t requeue_stale(std::chrono::seconds const max_age) {
+			std::size_t requeued = 0;
+			auto const now = std::filesystem::file_time_type::clock::now();
+			for (auto const& range : list_ranges(claimed_dir())) {
+				auto const name = game_range_file_name(range);
+				std::error_code error;
+				auto const last_heartbeat = std::filesystem::last_write_time(claimed_dir() / name, error);
+				if (error || now - last_heartbeat < max_age) {
+					continue;
+				}
+				if (std::filesystem::exists(results_dir() / name, error)) {
+					// Worker finished but died before releasing the claim.
+					std::filesystem::remove(claimed_dir() / name, error);
+					continue;
+				}
+				std::filesystem::rename(claimed_dir() / name, pending_dir() / name, error);
+				if (!error) {
+					++requeued;
+				}
+			}
+			return requeued;
+		}
+
+		// Results files of completed ranges.
+		// Partially written files are never visible, since they're renamed into place.
+		[[nodiscard]]
+		std::vector<std::filesystem::path> completed_result_files() const {
+			std::vector<std::filesystem::path> paths;
+			for (auto const& range : list_ranges(results_dir())) {
+				paths.push_back(results_dir() / game_range_file_name(range));
+			}
+			return paths;
+		}
+
+		[[nodiscard]]
+		work_queue_status_t status() const {
+			return {list_ranges(pending_dir()).size(), list_ranges(claimed_dir()).size(),
+				list_ranges(results_dir()).size()};
+		}
+
+	private:
+		std::filesystem::path _root;
+		std::minstd_rand _random{std::random_device{}()};
+
+		[[nodiscard]]
+		std::filesystem::path config_path() const {
+			return _root / "experiment.txt";
+		}
+
+		[[nodiscard]]
+		std::filesystem::path pending_dir() const {
+			return _root / "pending";
+		}
+
+		[[nodiscard]]
+		std::filesystem::path claimed_dir() const {
+			return _root / "claimed";
+		}
+
+		[[nodiscard]]
+		std::filesystem::path results_dir() const {
+			return _root / "results";
+		}
+
+		// Ranges with files in a directory. Anything else (e.g. temporary files) is ignored.
+		[[nodiscard]]
+		static std::vector<game_range_t> list_ranges(std::filesystem::path const& dir) {
+			std::vector<game_range_t> ranges;
+			std::error_code error;
+			for (auto const& entry : std::filesystem::directory_iterator{dir, error}) {
+				if (auto const range = parse_game_range_file_name(entry.path().filename().string());
+						range.has_value()) {
+					ranges.push_back(*range);
+				}
+			}
+			return ranges;
+		}
+	};
+
+
+	// Keeps a claim alive from a background thread while the range is being run.
+	class work_queue_heartbeat_t {
+	public:
+		work_queue_heartbeat_t(work_queue_t const& queue, game_range_t const range,
+				std::chrono::milliseconds const interval) :
+			_thread{[&queue, range, interval, this](std::stop_token const stop) {
+				std::unique_lock lock{_mutex};
+				while (true) {
+					// Only woken early by the stop request.
+					static_cast<void>(_stop_signal.wait_for(lock, stop, interval, [] { return false; }));
+					if (stop.stop_requested()) {
+						break;
+					}
+					queue.heartbeat(range);
+				}
+			}}
+		{}
+
+		work_queue_heartbeat_t(work_queue_heartbeat_t const&) = delete;
+		work_queue_heartbeat_t& operator=(work_queue_heartbeat_t const&) = delete;
+
+	private:
+		std::mutex _mutex;
+		std::condition_variable_any _stop_signal;
+		// Declared last so it's stopped and joined before the other members are destroyed.
+		std::jthread _thread;
+	};
+
+}